@@ -27,7 +27,12 @@ void RGB::setColor(int32_t r, int32_t g, int32_t b) {
     red = r;
     green = g;
     blue = b;
+#ifdef PIXELS_MONOCHROME
+    // lit if any of the components is above the half of its range
+    col = ((red | green | blue) & 0x80) != 0 ? 0xffff : 0;
+#else
     col = (((uint16_t)red / 8) << 11) | ((green / 4) << 5) | (blue / 8);
+#endif
 }
 
 
@@ -42,12 +47,11 @@ uint16_t RGB::convertRGBto565(RGB color) {
     return ((color.red / 8) << 11) | ((color.green / 4) << 5) | (color.blue / 8);
 }
 
-uint16_t RGB::convertTo565() {
-    return col; // ((red / 8) << 11) | ((green / 4) << 5) | (blue / 8);
-}
+#ifdef PIXELS_MONOCHROME
+RGB PixelsBase::monoColors[2] = {RGB(0, 0, 0), RGB(0xff, 0xff, 0xff)};
+#endif
 
-regtype *registerCS; // chip select
-regsize bitmaskCS;
+PixelsChipSelect* PixelsChipSelect::selectedChip = NULL;
 
 PixelsBase::PixelsBase(uint16_t width, uint16_t height) {
     deviceWidth = width < height ? width : height;
@@ -55,6 +59,9 @@ PixelsBase::PixelsBase(uint16_t width, uint16_t height) {
     this->width = width;
     this->height = height;
     setOrientation( width > height ? LANDSCAPE : PORTRAIT );
+    hardwareOrientation = false;
+    readBack = -1;
+    fileSource = NULL;
 
     relativeOrigin = true;
 
@@ -62,21 +69,52 @@ PixelsBase::PixelsBase(uint16_t width, uint16_t height) {
     scrollSupported = true;
     scrollEnabled = true;
     extraScrollDelay = 0;
+    scrolling = false;
+    marqueeRunning = false;
 
     lineWidth = 1;
     fillDirection = 0;
 
+#ifndef PIXELS_MONOCHROME
     computedBgColor = new RGB(0, 0, 0);
     computedFgColor = new RGB(0, 0, 0);
     bgBuffer = new RGB(0, 0, 0);
     fgBuffer = new RGB(0, 0, 0);
+    pixelBuffer = new RGB(0, 0, 0);
+#endif
 
     gfxOpNestingDepth = 0;
+#if PIXEL_BUFFER_SIZE > 0
+    pointBufferLength = 0;
+#endif
+
+    currentFont = NULL;
+#ifndef NO_GLYPH_INDEX
+    glyphIndex = NULL;
+    glyphIndexCapacity = 0;
+    glyphIndexLength = 0;
+    glyphIndexFirst = 0;
+#endif
 
     setBackground(0,0,0);
     setColor(0xFF,0xFF,0xFF);
 }
 
+PixelsBase::~PixelsBase() {
+#ifndef PIXELS_MONOCHROME
+    delete computedBgColor;
+    delete computedFgColor;
+    delete bgBuffer;
+    delete fgBuffer;
+    delete pixelBuffer;
+#endif
+#ifndef NO_GLYPH_INDEX
+    if ( glyphIndex != NULL ) {
+        delete[] glyphIndex;
+    }
+#endif
+}
+
 void PixelsBase::setOrientation( uint8_t direction ){
 
     if ( (orientation < 2 && direction > 1) || (orientation > 1 && direction < 2) ) {
@@ -119,9 +157,59 @@ void PixelsBase::clear() {
 }
 
 RGB* PixelsBase::getPixel(int16_t x, int16_t y) {
+    uint16_t color;
+    if ( readRegion(x, y, x, y, &color) ) {
+#ifdef PIXELS_MONOCHROME
+        return &monoColors[LIT565(color)];
+#else
+        *pixelBuffer = pixelBuffer->convert565toRGB(color);
+        return pixelBuffer;
+#endif
+    }
     return getBackground();
 }
 
+boolean PixelsBase::readRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t* out) {
+
+    if ( !canReadBack() ) {
+        return false;
+    }
+
+    int16_t w = x2 - x1 + 1;
+    Bounds bb(x1, y1, x2, y2);
+    WindowScan scan;
+    boolean result = false;
+
+    beginGfxOperation();
+
+    for ( uint8_t part = 0; part < 2; part++ ) {
+        if ( !openWindow(bb, part, scan, true) ) {
+            continue;
+        }
+
+        int16_t rx = scan.x;
+        int16_t ry = scan.y;
+        for ( int16_t r = 0; r < scan.rows; r++ ) {
+            int16_t x = rx;
+            int16_t y = ry;
+            for ( int16_t c = 0; c < scan.cols; c++ ) {
+                out[(int32_t)(y - y1) * w + x - x1] = deviceReadData();
+                x += scan.colDx;
+                y += scan.colDy;
+            }
+            rx += scan.rowDx;
+            ry += scan.rowDy;
+        }
+
+        endReadRegion();
+        result = true;
+    }
+
+    endGfxOperation();
+
+    return result;
+}
+
 void PixelsBase::drawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     beginGfxOperation();
@@ -156,15 +244,22 @@ void PixelsBase::drawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
                     sy = -1;
                 }
 
+                // pixels sharing a row (shallow line) or a column (steep line)
+                // are collected into a run and drawn as a single window
+                boolean steep = dy > dx;
                 int16_t x = x1;
                 int16_t y = y1;
+                int16_t runX = x;
+                int16_t runY = y;
                 int16_t err = dx - dy;
                 int16_t e2;
                 while (true) {
-                    drawPixel(x, y);
                     if (x == x2 && y == y2) {
+                        drawLineRun(runX, runY, x, y);
                         break;
                     }
+                    int16_t px = x;
+                    int16_t py = y;
                     e2 = err << 1;
                     if (e2 > -dy) {
                         err = err - dy;
@@ -174,7 +269,13 @@ void PixelsBase::drawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
                         err = err + dx;
                         y = y + sy;
                     }
+                    if ( steep ? x != runX : y != runY ) {
+                        drawLineRun(runX, runY, px, py);
+                        runX = x;
+                        runY = y;
+                    }
                 }
+                flushPixels();
             }
         } else {
             drawFatLineAntialiased(x1, y1, x2, y2);
@@ -184,6 +285,30 @@ void PixelsBase::drawLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     endGfxOperation();
 }
 
+void PixelsBase::drawLineRun(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    if ( x2 < x1 ) {
+        swap(x1, x2);
+    }
+    if ( y2 < y1 ) {
+        swap(y1, y2);
+    }
+    // clip to the screen, so the run never wraps around with absolute origin
+    if ( x2 < 0 || y2 < 0 || x1 >= width || y1 >= height ) {
+        return;
+    }
+    x1 = max(x1, (int16_t)0);
+    y1 = max(y1, (int16_t)0);
+    x2 = min(x2, (int16_t)(width - 1));
+    y2 = min(y2, (int16_t)(height - 1));
+
+    if ( x1 == x2 && y1 == y2 ) {
+        // lone pixels of diagonal stretches still go through the point buffer
+        bufferPixel(x1, y1);
+    } else {
+        fill(foregroundColor, x1, y1, x2, y2);
+    }
+}
+
 void PixelsBase::drawRectangle(int16_t x, int16_t y, int16_t width, int16_t height) {
     beginGfxOperation();
     hLine(x, y, x+width-2);
@@ -195,7 +320,7 @@ void PixelsBase::drawRectangle(int16_t x, int16_t y, int16_t width, int16_t heig
 
 void PixelsBase::fillRectangle(int16_t x, int16_t y, int16_t width, int16_t height) {
     beginGfxOperation();
-    fill(foreground->convertTo565(), x, y, x+width-1, y+height-1);
+    fill(foregroundColor, x, y, x+width-1, y+height-1);
     endGfxOperation();
 }
 
@@ -247,15 +372,16 @@ void PixelsBase::drawRoundRectangle(int16_t x, int16_t y, int16_t width, int16_t
             ddF_x += 2;
             f += ddF_x;
 
-            drawPixel(xx + x1 + shiftX, yy + y1 + shiftY);
-            drawPixel(xx - x1, yy + y1 + shiftY);
-            drawPixel(xx + x1 + shiftX, yy - y1);
-            drawPixel(xx - x1, yy - y1);
-            drawPixel(xx + y1 + shiftX, yy + x1 + shiftY);
-            drawPixel(xx - y1, yy + x1 + shiftY);
-            drawPixel(xx + y1 + shiftX, yy - x1);
-            drawPixel(xx - y1, yy - x1);
+            bufferPixel(xx + x1 + shiftX, yy + y1 + shiftY);
+            bufferPixel(xx - x1, yy + y1 + shiftY);
+            bufferPixel(xx + x1 + shiftX, yy - y1);
+            bufferPixel(xx - x1, yy - y1);
+            bufferPixel(xx + y1 + shiftX, yy + x1 + shiftY);
+            bufferPixel(xx - y1, yy + x1 + shiftY);
+            bufferPixel(xx + y1 + shiftX, yy - x1);
+            bufferPixel(xx - y1, yy - x1);
         }
+        flushPixels();
     }
 
     endGfxOperation();
@@ -438,13 +564,13 @@ void PixelsBase::drawOval(int16_t x, int16_t y, int16_t width, int16_t height) {
                     if (k > 0) {
                         ypk = yy + k;
                         ymk = yy - k;
-                        drawPixel(xmh, ypk);
-                        drawPixel(xph, ypk);
-                        drawPixel(xmh, ymk);
-                        drawPixel(xph, ymk);
+                        bufferPixel(xmh, ypk);
+                        bufferPixel(xph, ypk);
+                        bufferPixel(xmh, ymk);
+                        bufferPixel(xph, ymk);
                     } else {
-                        drawPixel(xmh, yy);
-                        drawPixel(xph, yy);
+                        bufferPixel(xmh, yy);
+                        bufferPixel(xph, yy);
                     }
                     ok = k;
                     xpi = xx + i;
@@ -452,13 +578,13 @@ void PixelsBase::drawOval(int16_t x, int16_t y, int16_t width, int16_t height) {
                     if (j > 0) {
                         ypj = yy + j;
                         ymj = yy - j;
-                        drawPixel(xmi, ypj);
-                        drawPixel(xpi, ypj);
-                        drawPixel(xmi, ymj);
-                        drawPixel(xpi, ymj);
+                        bufferPixel(xmi, ypj);
+                        bufferPixel(xpi, ypj);
+                        bufferPixel(xmi, ymj);
+                        bufferPixel(xpi, ymj);
                     } else {
-                        drawPixel(xmi, yy);
-                        drawPixel(xpi, yy);
+                        bufferPixel(xmi, yy);
+                        bufferPixel(xpi, yy);
                     }
                     oj = j;
                 }
@@ -483,13 +609,13 @@ void PixelsBase::drawOval(int16_t x, int16_t y, int16_t width, int16_t height) {
                     if (i > 0) {
                         ypi = yy + i;
                         ymi = yy - i;
-                        drawPixel(xmj, ypi);
-                        drawPixel(xpj, ypi);
-                        drawPixel(xmj, ymi);
-                        drawPixel(xpj, ymi);
+                        bufferPixel(xmj, ypi);
+                        bufferPixel(xpj, ypi);
+                        bufferPixel(xmj, ymi);
+                        bufferPixel(xpj, ymi);
                     } else {
-                        drawPixel(xmj, yy);
-                        drawPixel(xpj, yy);
+                        bufferPixel(xmj, yy);
+                        bufferPixel(xpj, yy);
                     }
                     oi = i;
                     xmk = xx - k;
@@ -497,13 +623,13 @@ void PixelsBase::drawOval(int16_t x, int16_t y, int16_t width, int16_t height) {
                     if (h > 0) {
                         yph = yy + h;
                         ymh = yy - h;
-                        drawPixel(xmk, yph);
-                        drawPixel(xpk, yph);
-                        drawPixel(xmk, ymh);
-                        drawPixel(xpk, ymh);
+                        bufferPixel(xmk, yph);
+                        bufferPixel(xpk, yph);
+                        bufferPixel(xmk, ymh);
+                        bufferPixel(xpk, ymh);
                     } else {
-                        drawPixel(xmk, yy);
-                        drawPixel(xpk, yy);
+                        bufferPixel(xmk, yy);
+                        bufferPixel(xpk, yy);
                     }
                     oh = h;
                 }
@@ -513,6 +639,7 @@ void PixelsBase::drawOval(int16_t x, int16_t y, int16_t width, int16_t height) {
 
             } while (i > h);
         }
+        flushPixels();
     }
 
     endGfxOperation();
@@ -682,20 +809,32 @@ int8_t PixelsBase::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t heigh
     }
 
     beginGfxOperation();
-    setRegion(bb.x1, bb.y1, bb.x2, bb.y2);
 
-    int sc = currentScroll;
-    if ( sc == 0 ) {
-        sc = deviceHeight;
+    uint8_t scan = orientation;
+    if ( orientRegion(bb.x1, bb.y1, bb.x2, bb.y2) ) {
+        // the controller scans the region in logical order: bitmap rows are streamed as they are stored
+        untransformBounds(bb);
+        scan = PORTRAIT;
+    } else {
+        setRegion(bb.x1, bb.y1, bb.x2, bb.y2);
     }
 
-    switch( orientation ) {
+    // the logical x limit checkBounds() clipped against: the scroll only splits the screen in relative origin
+    int sc = relativeOrigin && currentScroll > 0 ? currentScroll : deviceHeight;
+
+    uint16_t chunk[PIXEL_CHUNK_SIZE];
+    uint8_t chunkLength = 0;
+
+    switch( scan ) {
     case PORTRAIT:
         {
             for ( int16_t j = bb.y1; j <= bb.y2; j++ ) {
                 for ( int16_t i = bb.x1; i <= bb.x2; i++ ) {
-                    int16_t px = pgm_read_word_near(data + (j - y) * width + i - x);
-                    setCurrentPixel(px);
+                    chunk[chunkLength++] = pgm_read_word_near(data + (j - y) * width + i - x);
+                    if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+                        deviceWritePixels(chunk, chunkLength);
+                        chunkLength = 0;
+                    }
                 }
             }
         }
@@ -708,8 +847,11 @@ int8_t PixelsBase::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t heigh
             int h = bb.y2 - bb.y1 + 1;
             for ( int16_t j = h - 1; j >= 0; j-- ) {
                 for ( int16_t i = 0; i < w; i++ ) {
-                    int16_t px = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
-                    setCurrentPixel(px);
+                    chunk[chunkLength++] = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
+                    if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+                        deviceWritePixels(chunk, chunkLength);
+                        chunkLength = 0;
+                    }
                 }
             }
         }
@@ -722,8 +864,11 @@ int8_t PixelsBase::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t heigh
             int cutW = x < 0 ? 0 : width - w;
             for ( int16_t j = 0; j < h; j++ ) {
                 for ( int16_t i = 0; i < w; i++ ) {
-                    int16_t px = pgm_read_word_near(data + (height - j - 1 - cutH) * width + (width - i - 1 - cutW));
-                    setCurrentPixel(px);
+                    chunk[chunkLength++] = pgm_read_word_near(data + (height - j - 1 - cutH) * width + (width - i - 1 - cutW));
+                    if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+                        deviceWritePixels(chunk, chunkLength);
+                        chunkLength = 0;
+                    }
                 }
             }
         }
@@ -736,24 +881,38 @@ int8_t PixelsBase::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t heigh
             int h = bb.y2 - bb.y1 + 1;
             for ( int16_t j = 0; j < h; j++ ) {
                 for ( int16_t i = w - 1; i >= 0; i-- ) {
-                    int16_t px = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
-                    setCurrentPixel(px);
+                    chunk[chunkLength++] = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
+                    if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+                        deviceWritePixels(chunk, chunkLength);
+                        chunkLength = 0;
+                    }
                 }
             }
         }
         break;
     }
 
+    deviceWritePixels(chunk, chunkLength);
+
     endGfxOperation();
     return 0;
 }
 
 int8_t PixelsBase::drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data) {
+    return drawCompressedBitmapRegion(x, y, data, 0, 0, 0x7fff, 0x7fff);
+}
+
+int8_t PixelsBase::drawCompressedBitmapRegion(int16_t x, int16_t y, prog_uchar* data,
+                                              int16_t sx, int16_t sy, int16_t sw, int16_t sh) {
 
     if ( data == NULL ) {
         return -1;
     }
 
+    if ( pgm_read_byte_near(data + 0) == 'R' ) {
+        return drawRunLengthBitmap(x, y, data, sx, sy, sw, sh);
+    }
+
     if ( pgm_read_byte_near(data + 0) != 'Z' ) {
         // Unknown compression method
         return -2;
@@ -789,6 +948,22 @@ int8_t PixelsBase::drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data)
         return -7;
     }
 
+    beginGfxOperation();
+
+    Bounds rb(0, 0, 0, 0);
+    boolean stream;
+    if ( !openRasterRegion(x, y, width, height, sx, sy, sw, sh, rb, stream) ) {
+        endGfxOperation();
+        return 1;
+    }
+
+    // the stream has no entry points: it is decoded from the start up to the last visible row
+    int16_t row = 0;
+    int16_t firstRow = rb.y1 - y + sy;
+    int16_t lastRow = rb.y2 - y + sy;
+    int16_t rasterOffset = rb.x1 - x + sx;
+    int16_t rasterWidth = rb.x2 - rb.x1 + 1;
+
     uint8_t window[windowLen];
     int16_t wptr = 0;
 
@@ -797,16 +972,13 @@ int8_t PixelsBase::drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data)
     uint8_t buf;
     bool bufEmpty = true;
 
-    int* raster = NULL;
+    uint16_t* raster = NULL;
     int rasterPtr = 0;
-    int rasterLine = y;
 
-    raster = new int[width];
-
-    beginGfxOperation();
+    raster = new uint16_t[width];
 
     BitStream bs( data, compressedLen, 96 );
-    while ( true ) {
+    while ( row <= lastRow ) {
 
         uint8_t bit = bs.readBit();
         if ( bit == 0 ) { // literal
@@ -820,35 +992,10 @@ int8_t PixelsBase::drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data)
                 px |= bits;
                 raster[rasterPtr++] = px;
                 if ( rasterPtr == width ) {
-                    Bounds bb(x, rasterLine, x + width - 1, rasterLine);
-                    if( transformBounds(bb) && checkBounds(bb) ) {
-                        setRegion(bb.x1, bb.y1, bb.x2, bb.y2);
-
-                        int ww = width;
-                        int corr = 0;
-                        if (bb.x1 == bb.x2) {
-                            ww = bb.y2 - bb.y1 + 1;
-                        } else {
-                            ww = bb.x2 - bb.x1 + 1;
-                        }
-
-                        if (x < 0) {
-                            corr = -x;
-                            ww += corr;
-                        }
-
-                        if ( orientation < 2 ) {
-                            for ( int i = corr; i < ww; i++ ) {
-                                setCurrentPixel(raster[i]);
-                            }
-                        } else {
-                            for ( int i = min(width, ww - 1); i >= corr; i-- ) {
-                                setCurrentPixel(raster[i]);
-                            }
-                        }
+                    if ( row >= firstRow && row <= lastRow ) {
+                        writeRasterRow(stream, rb.x1, row - sy + y, raster + rasterOffset, rasterWidth);
                     }
-
-                    rasterLine++;
+                    row++;
                     rasterPtr = 0;
                 }
                 bufEmpty = true;
@@ -887,36 +1034,10 @@ int8_t PixelsBase::drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data)
 
                     raster[rasterPtr++] = px;
                     if ( rasterPtr == width ) {
-                        Bounds bb(x, rasterLine, x + width - 1, rasterLine);
-                        if( transformBounds(bb) && checkBounds(bb) ) {
-                            setRegion(bb.x1, bb.y1, bb.x2, bb.y2);
-
-                            int corr = 0;
-                            int ww;
-                            if (bb.x1 == bb.x2) {
-                                ww = bb.y2 - bb.y1 + 1;
-                            } else {
-                                ww = bb.x2 - bb.x1 + 1;
-                            }
-
-                            if (x < 0) {
-                                corr = -x;
-                                ww += corr;
-                            }
-
-
-                            if ( orientation < 2 ) {
-                                for ( int i = corr; i < ww; i++ ) {
-                                    setCurrentPixel(raster[i]);
-                                }
-                            } else {
-                                for ( int i = min(width, ww - 1); i >= corr; i-- ) {
-                                    setCurrentPixel(raster[i]);
-                                }
-                            }
+                        if ( row >= firstRow && row <= lastRow ) {
+                            writeRasterRow(stream, rb.x1, row - sy + y, raster + rasterOffset, rasterWidth);
                         }
-
-                        rasterLine++;
+                        row++;
                         rasterPtr = 0;
                     }
                     bufEmpty = true;
@@ -933,204 +1054,642 @@ int8_t PixelsBase::drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data)
         }
     }
 
-    delete raster;
+    delete[] raster;
 
     endGfxOperation();
 
     return 0;
 }
 
+void PixelsBase::writeRasterLine(int16_t x, int16_t y, const uint16_t* raster, int16_t width) {
+    Bounds bb(x, y, x + width - 1, y);
+    if( !transformBounds(bb) || !checkBounds(bb) ) {
+        return;
+    }
 
-int8_t PixelsBase::loadBitmap(int16_t x, int16_t y, int16_t sx, int16_t sy, String path) {
-//    int16_t* data = loadFileBytes( path );
-    return 0; // drawBitmap(x, y, sx, sy, data);
-}
-
-/*  -------   Antialiasing ------- */
-/* To be overriden with Pixels_Antialiasing.h */
-
-void PixelsBase::drawLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {}
+    boolean oriented = orientRegion(bb.x1, bb.y1, bb.x2, bb.y2);
+    if ( !oriented ) {
+        setRegion(bb.x1, bb.y1, bb.x2, bb.y2);
+    }
 
-void PixelsBase::drawFatLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {}
+    int16_t corr = 0;
+    int16_t ww;
+    if (bb.x1 == bb.x2) {
+        ww = bb.y2 - bb.y1 + 1;
+    } else {
+        ww = bb.x2 - bb.x1 + 1;
+    }
 
-void PixelsBase::drawRoundRectangleAntialiased(int16_t x, int16_t y, int16_t width, int16_t height, int16_t rx, int16_t ry, boolean bordermode) {}
+    if (x < 0) {
+        corr = -x;
+        ww += corr;
+    }
 
-void PixelsBase::drawCircleAntialiaced( int16_t x, int16_t y, int16_t radius, boolean bordermode )	{}
+    if ( orientation < 2 || oriented ) {
+        deviceWritePixels(raster + corr, ww - corr);
+        return;
+    }
 
-/* TEXT */
+    // flipped orientations scan the line backwards
+    uint16_t chunk[PIXEL_CHUNK_SIZE];
+    uint8_t chunkLength = 0;
+    for ( int16_t i = ww - 1; i >= corr; i-- ) {
+        chunk[chunkLength++] = raster[i];
+        if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+            deviceWritePixels(chunk, chunkLength);
+            chunkLength = 0;
+        }
+    }
+    deviceWritePixels(chunk, chunkLength);
+}
 
+boolean PixelsBase::openRasterRegion(int16_t x, int16_t y, int16_t width, int16_t height,
+                                     int16_t sx, int16_t sy, int16_t sw, int16_t sh, Bounds& rb, boolean& stream) {
+    if ( sx < 0 ) {
+        sw += sx;
+        x -= sx;
+        sx = 0;
+    }
+    if ( sy < 0 ) {
+        sh += sy;
+        y -= sy;
+        sy = 0;
+    }
+    if ( sw > width - sx ) {
+        sw = width - sx;
+    }
+    if ( sh > height - sy ) {
+        sh = height - sy;
+    }
+    if ( sw <= 0 || sh <= 0 ) {
+        return false;
+    }
 
-int PixelsBase::setFont(prog_uchar font[]) {
-    int16_t p1 = pgm_read_byte_near(font + 0);
-    int16_t p2 = pgm_read_byte_near(font + 1);
-    if ( p1 != 'Z' || p2 != 'F' ) {
-//			Serial.print("Invalid font prefix ");
-//			Serial.print( p1 );
-//			Serial.print( " " );
-//			Serial.println( p2 );
-        currentFont = NULL;
-        return -1;
+    Bounds bb(x, y, x + sw - 1, y + sh - 1);
+    if( !transformBounds(bb) ) {
+        return false;
     }
-    int16_t fontType = pgm_read_byte_near(font + 2);
-    if ( fontType != ANTIALIASED_FONT && fontType != BITMASK_FONT ) {
-//			Serial.println("Unsupported font type");
-        currentFont = NULL;
-        return -1;
+    rb = bb;
+    if( !checkBounds(rb) ) {
+        return false;
     }
-    currentFont = font;
-    return 0;
+
+    // an unclipped region the controller scans in logical order goes through a single window,
+    // otherwise every row is output with writeRasterLine()
+    stream = rb.x1 == bb.x1 && rb.y1 == bb.y1 && rb.x2 == bb.x2 && rb.y2 == bb.y2;
+    if ( stream ) {
+        if ( orientation == PORTRAIT ) {
+            setRegion(rb.x1, rb.y1, rb.x2, rb.y2);
+        } else {
+            stream = orientRegion(rb.x1, rb.y1, rb.x2, rb.y2);
+        }
+    }
+
+    untransformBounds(rb);
+    return true;
 }
 
-void PixelsBase::print(int16_t xx, int16_t yy, String text, int8_t kerning[]) {
+/*
+ * 'R' format: byte aligned opcodes on whole 565 pixels, decoded line by line into burst writes.
+ *
+ * bytes 0-9: 'R', opcode stream length (24bit), width, height and checkpoint interval (16bit each),
+ * followed by the opcode stream offsets (24bit) of every checkpoint row but the first one. All big endian
+ *
+ * 00nnnnnn           previous pixel repeated n + 1 times
+ * 01iiiiii           pixel from a table of 64 recently seen colors, indexed by RLE_HASH
+ * 10rrggbb           previous pixel with red, green and blue changed by rr - 2, gg - 2 and bb - 2
+ * 110ggggg rrrrbbbb  previous pixel with green changed by dg = ggggg - 16, red and blue
+ *                    changed by dg / 2 + rrrr - 8 and dg / 2 + bbbb - 8
+ * 1110nnnn           n + 1 literal pixels follow, 2 bytes each
+ * 1111nnnn           n + 1 pixels copied from the line above
+ *
+ * Channels wrap around. The previous pixel, all table entries and the line above are black at
+ * checkpoint rows (every interval rows, the first row only if the interval is 0), so decoding can
+ * start at any of them. Opcodes do not reach across checkpoint rows. Literal and changed pixels
+ * are stored to the table. See extras/encoder for a host encoder
+ */
+#define RLE_HASH(c) (((c) * 3 + ((c) >> 5) * 5 + ((c) >> 11) * 7) & 0x3f)
+
+int8_t PixelsBase::drawRunLengthBitmap(int16_t x, int16_t y, prog_uchar* data,
+                                       int16_t sx, int16_t sy, int16_t sw, int16_t sh) {
+
+    int32_t length = ((int32_t)pgm_read_byte_near(data + 1) << 16) + ((int32_t)pgm_read_byte_near(data + 2) << 8) + pgm_read_byte_near(data + 3);
+    int16_t width = ((int16_t)pgm_read_byte_near(data + 4) << 8) + pgm_read_byte_near(data + 5);
+    int16_t height = ((int16_t)pgm_read_byte_near(data + 6) << 8) + pgm_read_byte_near(data + 7);
+    int16_t interval = ((int16_t)pgm_read_byte_near(data + 8) << 8) + pgm_read_byte_near(data + 9);
+    if ( width <= 0 || height <= 0 || interval < 0 ) {
+        // compression format error (width, height or checkpoint interval parameter is invalid)
+        return -6;
+    }
+
     beginGfxOperation();
-    printString(xx, yy, text, 0, kerning);
-    endGfxOperation();
-}
 
+    Bounds rb(0, 0, 0, 0);
+    boolean stream;
+    if ( !openRasterRegion(x, y, width, height, sx, sy, sw, sh, rb, stream) ) {
+        endGfxOperation();
+        return 1;
+    }
 
-#ifndef NO_TEXT_WRAP
-int16_t PixelsBase::computeBreakPos(String text, int16_t t) {
-    int16_t breakPos = -1;
-    String s = t == 0 ? text : text.substring(t, text.length());
-    int16_t w = getTextWidth(s);
-    if ( w + caretX > width - textWrapMarginRight || text.indexOf('\n') >= 0 ) {
-        char prev = 0;
-        w = 0;
-        for ( uint16_t j = t; j < text.length(); j++ ) {
-            char cc = text.charAt(j);
-            w += getCharWidth(cc);
-            if ( (cc == ' ' && prev != ' ') || (cc == '\n' && breakPos >= 0) ) {
-                if ( caretX + w > width - textWrapMarginRight ) {
+    int16_t firstRow = rb.y1 - y + sy;
+    int16_t lastRow = rb.y2 - y + sy;
+    int16_t rasterOffset = rb.x1 - x + sx;
+    int16_t rasterWidth = rb.x2 - rb.x1 + 1;
+
+    prog_uchar* index = data + 10;
+    prog_uchar* ptr = index + (interval > 0 ? (height - 1) / interval * 3 : 0);
+    prog_uchar* end = ptr + length;
+
+    // decoding starts at the last checkpoint row not below the first visible one
+    int16_t row = 0;
+    if ( interval > 0 && firstRow >= interval ) {
+        int16_t checkpoint = firstRow / interval;
+        prog_uchar* p = index + (checkpoint - 1) * 3;
+        ptr += ((int32_t)pgm_read_byte_near(p) << 16) + ((int32_t)pgm_read_byte_near(p + 1) << 8) + pgm_read_byte_near(p + 2);
+        row = checkpoint * interval;
+    }
+
+    // the current line is decoded over the line above
+    uint16_t* raster = new uint16_t[width];
+    memset(raster, 0, width * sizeof(uint16_t));
+    int16_t rasterPtr = 0;
+
+    uint16_t table[64];
+    memset(table, 0, sizeof(table));
+    uint16_t color = 0;
+
+    while ( row <= lastRow && ptr < end ) {
+        uint8_t op = pgm_read_byte_near(ptr++);
+        uint8_t n = 1;
+
+        if ( op < 0x40 ) {
+            n = op + 1;
+        } else if ( op < 0x80 ) {
+            color = table[op & 0x3f];
+        } else if ( op < 0xc0 ) {
+            uint16_t r = ((color >> 11) + ((op >> 4) & 3) - 2) & 0x1f;
+            uint16_t g = ((color >> 5) + ((op >> 2) & 3) - 2) & 0x3f;
+            uint16_t b = (color + (op & 3) - 2) & 0x1f;
+            color = (r << 11) | (g << 5) | b;
+            table[RLE_HASH(color)] = color;
+        } else if ( op < 0xe0 ) {
+            uint8_t redBlue = pgm_read_byte_near(ptr++);
+            int8_t dg = (int8_t)(op & 0x1f) - 16;
+            int8_t h = dg >> 1;
+            uint16_t r = ((color >> 11) + h + (redBlue >> 4) - 8) & 0x1f;
+            uint16_t g = ((color >> 5) + dg) & 0x3f;
+            uint16_t b = (color + h + (redBlue & 0x0f) - 8) & 0x1f;
+            color = (r << 11) | (g << 5) | b;
+            table[RLE_HASH(color)] = color;
+        } else {
+            n = (op & 0x0f) + 1;
+        }
+
+        while ( n-- > 0 ) {
+            if ( op >= 0xf0 ) {
+                color = raster[rasterPtr];
+            } else if ( op >= 0xe0 ) {
+                color = ((uint16_t)pgm_read_byte_near(ptr) << 8) | pgm_read_byte_near(ptr + 1);
+                ptr += 2;
+                table[RLE_HASH(color)] = color;
+            }
+            raster[rasterPtr++] = color;
+            if ( rasterPtr == width ) {
+                if ( row >= firstRow ) {
+                    writeRasterRow(stream, rb.x1, row - sy + y, raster + rasterOffset, rasterWidth);
+                }
+                rasterPtr = 0;
+                if ( ++row > lastRow ) {
+                    break;
+                }
+                if ( interval > 0 && row % interval == 0 ) {
+                    memset(raster, 0, width * sizeof(uint16_t));
+                    memset(table, 0, sizeof(table));
+                    color = 0;
                     break;
-                } else {
-                    breakPos = j;
-                    if ( cc == '\n' ) {
-                        break;
-                    }
                 }
-            } else if ( cc == '\n' ) {
-                breakPos = j;
-                break;
             }
-            prev = cc;
         }
     }
-    return breakPos;
-}
-#endif
 
-void PixelsBase::cleanText(int16_t xx, int16_t yy, String text, int8_t kerning[]) {
-    beginGfxOperation();
-    printString(xx, yy, text, 1, kerning);
     endGfxOperation();
-}
 
-void PixelsBase::printString(int16_t xx, int16_t yy, String text, boolean clean, int8_t kerning[]) {
+    delete[] raster;
 
-    if ( currentFont == NULL ) {
-        return;
-    }
+    // compressed data inconsistence if the stream ends before the region does
+    return row <= lastRow ? -3 : 0;
+}
 
-    int16_t fontType = pgm_read_byte_near(currentFont + 2);
-    if ( fontType != ANTIALIASED_FONT && fontType != BITMASK_FONT ) {
-        return;
+int8_t PixelsBase::loadBitmap(int16_t x, int16_t y, int16_t width, int16_t height, String path) {
+    if ( fileSource == NULL || !fileSource->open(path.c_str()) ) {
+        return -1;
     }
+    int8_t result = streamBitmap(x, y, width, height);
+    fileSource->close();
+    return result;
+}
 
-    RGB* fg = foreground;
+#define FILE_RAW565 0
+#define FILE_BMP565 1
+#define FILE_BMP555 2
+#define FILE_BMP888 3
 
-    int16_t kernPtr = 0;
-    int16_t kern = -100; // no kerning
+#define BMP_HEADER_LENGTH 58 // file and info headers up to the red color mask
 
-    int16_t glyphHeight = pgm_read_byte_near(currentFont + 3);
+static int32_t readBytes(PixelsFileSource* file, uint8_t* buffer, int32_t length) {
+    int32_t total = 0;
+    while ( total < length ) {
+        int32_t n = file->read(buffer + total, length - total);
+        if ( n <= 0 ) {
+            break;
+        }
+        total += n;
+    }
+    return total;
+}
 
-    caretX = xx;
-    caretY = yy;
+static uint32_t littleEndian(uint8_t* data, uint8_t length) {
+    uint32_t value = 0;
+    while ( length-- > 0 ) {
+        value = (value << 8) | data[length];
+    }
+    return value;
+}
 
-    int16_t glyphWidth = 0;
-    int breakPos = -1;
+int8_t PixelsBase::streamBitmap(int16_t x, int16_t y, int16_t width, int16_t height) {
 
-#ifndef NO_TEXT_WRAP
-    boolean relOrigin = isOriginRelative();
-    if ( wrapText ) {
-        breakPos = computeBreakPos(text, 0);
-    }
-#endif
+    uint8_t bytes[FILE_CHUNK_SIZE * 3 > BMP_HEADER_LENGTH ? FILE_CHUNK_SIZE * 3 : BMP_HEADER_LENGTH];
+    uint16_t pixels[FILE_CHUNK_SIZE];
 
-    for (uint16_t t = 0; t < text.length(); t++) {
-        char c = text.charAt(t);
+    int32_t position = readBytes(fileSource, bytes, BMP_HEADER_LENGTH);
 
-#ifndef NO_TEXT_WRAP
-        if ( t == breakPos ) {
-            if ( c == ' ' || c == '\n' ) {
-                breakPos++;
-                continue;
-            }
-            caretX = textWrapMarginLeft;
-            caretY = caretY + glyphHeight + textWrapLineGap;
-            if ( textWrapScroll && (orientation == PORTRAIT_FLIP || orientation == PORTRAIT) &&
-                    caretY + glyphHeight + textWrapMarginBottom > height ) {
+    uint8_t format = FILE_RAW565;
+    uint8_t depth = 2; // bytes per pixel
+    uint32_t offset = 0; // position of the first stored row
+    uint32_t stride; // bytes per stored row
+    int32_t rows = height;
+    boolean bottomUp = false;
 
-                RGB* sav = NULL;
-                if ( textWrapScrollFill != NULL ) {
-                    sav = getBackground();
-                    setBackground(textWrapScrollFill);
-                }
-                scroll(-(height - caretY - glyphHeight - textWrapMarginBottom), SCROLL_SMOOTH | SCROLL_CLEAN);
-                if ( sav != NULL ) {
-                    setBackground(sav);
-                }
-                setOriginAbsolute();
+    if ( position >= 2 && bytes[0] == 'B' && bytes[1] == 'M' ) {
+        if ( position < BMP_HEADER_LENGTH - 4 ) {
+            return -2;
+        }
+        offset = littleEndian(bytes + 10, 4);
+        int32_t w = littleEndian(bytes + 18, 4);
+        rows = littleEndian(bytes + 22, 4);
+        uint16_t bits = littleEndian(bytes + 28, 2);
+        uint32_t compression = littleEndian(bytes + 30, 4);
+        // a negative height marks rows stored top to bottom
+        bottomUp = rows > 0;
+        if ( rows < 0 ) {
+            rows = -rows;
+        }
 
-                caretY = height - glyphHeight - textWrapMarginBottom;
+        if ( bits == 24 && compression == 0 ) {
+            format = FILE_BMP888;
+            depth = 3;
+        } else if ( bits == 16 && compression == 0 ) {
+            format = FILE_BMP555;
+        } else if ( bits == 16 && compression == 3 && position == BMP_HEADER_LENGTH ) {
+            uint32_t red = littleEndian(bytes + 54, 4);
+            if ( red == 0xf800 ) {
+                format = FILE_BMP565;
+            } else if ( red == 0x7c00 ) {
+                format = FILE_BMP555;
+            } else {
+                return -2;
             }
-            breakPos = computeBreakPos(text, t);
+        } else {
+            return -2;
+        }
+        if ( w <= 0 || w > 0x7fff || rows == 0 || rows > 0x7fff ) {
+            return -2;
         }
 
-        boolean repeat = false;
-#endif
+        stride = ((uint32_t)w * depth + 3) & ~3;
+        if ( width <= 0 || width > w ) {
+            width = w;
+        }
+        if ( height <= 0 || height > rows ) {
+            height = rows;
+        }
+    } else {
+        if ( width <= 0 || height <= 0 ) {
+            return -2;
+        }
+        stride = (uint32_t)width * 2;
+    }
 
-        boolean found = false;
-        int16_t ptr = HEADER_LENGTH;
-        while ( 1 ) {
-            char cx = (char)(((int)pgm_read_byte_near(currentFont + ptr + 0) << 8) + pgm_read_byte_near(currentFont + ptr + 1));
-            if ( cx == 0 ) {
-              break;
-            }
-            int16_t length = (((int)(pgm_read_byte_near(currentFont + ptr + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(currentFont + ptr + 3) & 0xff));
+    beginGfxOperation();
 
-            if ( cx == c ) {
-                if ( length < 8 ) {
-//						Serial.print( "Invalid "  );
-//						Serial.print( c );
-//						Serial.println( " glyph definition. Font corrupted?" );
-                    break;
-                }
+    Bounds rb(0, 0, 0, 0);
+    boolean stream;
+    if ( !openRasterRegion(x, y, width, height, 0, 0, width, height, rb, stream) ) {
+        endGfxOperation();
+        return 1;
+    }
 
-                glyphWidth = 0xff & pgm_read_byte_near(currentFont + ptr + 4);
-                found = true;
+    int8_t result = 0;
+    for ( int16_t line = rb.y1; line <= rb.y2 && result == 0; line++ ) {
+        int16_t row = line - y;
+        uint32_t rowStart = offset + (uint32_t)(bottomUp ? rows - 1 - row : row) * stride + (uint32_t)(rb.x1 - x) * depth;
 
-#ifndef NO_TEXT_WRAP
-                if ( wrapText && caretX + glyphWidth > width - textWrapMarginRight ) {
-                    breakPos = t;
-                    repeat = true;
+        for ( int16_t col = rb.x1; col <= rb.x2; ) {
+            int16_t count = rb.x2 - col + 1;
+            if ( count > FILE_CHUNK_SIZE ) {
+                count = FILE_CHUNK_SIZE;
+            }
+            int32_t length = (int32_t)count * depth;
+
+            // the file may share the bus with the display (e.g. an SD card on SPI): the display is released while reading
+            endGfxOperation();
+            boolean ok = (position == (int32_t)rowStart || fileSource->seek(rowStart)) && readBytes(fileSource, bytes, length) == length;
+            beginGfxOperation();
+            if ( !ok ) {
+                result = -3;
+                break;
+            }
+            position = rowStart + length;
+            rowStart += length;
+
+            uint8_t* b = bytes;
+            for ( int16_t i = 0; i < count; i++, b += depth ) {
+                switch( format ) {
+                case FILE_RAW565:
+                    pixels[i] = ((uint16_t)b[0] << 8) | b[1];
+                    break;
+                case FILE_BMP565:
+                    pixels[i] = ((uint16_t)b[1] << 8) | b[0];
+                    break;
+                case FILE_BMP555:
+                    {
+                        uint16_t c = ((uint16_t)b[1] << 8) | b[0];
+                        pixels[i] = ((c & 0x7fe0) << 1) | ((c >> 4) & 0x20) | (c & 0x1f);
+                    }
+                    break;
+                case FILE_BMP888:
+                    pixels[i] = ((uint16_t)(b[2] & 0xf8) << 8) | ((uint16_t)(b[1] & 0xfc) << 3) | (b[0] >> 3);
                     break;
                 }
-#endif
+            }
 
-                drawGlyph(fontType, clean, caretX, caretY, glyphHeight, currentFont + ptr, length);
-                break;
+            if ( stream ) {
+                deviceWritePixels(pixels, count);
+            } else {
+                writeRasterLine(col, line, pixels, count);
             }
-            ptr += length;
+            col += count;
         }
+    }
 
-#ifndef NO_TEXT_WRAP
-        if ( repeat ) {
-            t--;
-            continue;
-        }
-#endif
+    endGfxOperation();
+    return result;
+}
 
-        if ( kerning != NULL && kerning[kernPtr] > -100 ) {
+int8_t PixelsBase::drawRasterAsync(int16_t x, int16_t y, int16_t width, int16_t height, const uint16_t* data,
+                                   PixelsTransferDone done, void* context) {
+
+    beginGfxOperation();
+
+    Bounds rb(0, 0, 0, 0);
+    boolean stream;
+    if ( !openRasterRegion(x, y, width, height, 0, 0, width, height, rb, stream) ) {
+        endGfxOperation();
+        return 1;
+    }
+
+    uint32_t n = (uint32_t)width * height;
+    if ( !stream ) {
+        for ( int16_t line = rb.y1; line <= rb.y2; line++ ) {
+            writeRasterLine(rb.x1, line, data + (int32_t)(line - y) * width + rb.x1 - x, rb.x2 - rb.x1 + 1);
+        }
+    } else if ( queuePixels(data, n, done, context) ) {
+        // the display stays selected until the queue is sent
+        endGfxOperation();
+        return 0;
+    } else {
+        deviceWritePixels(data, n);
+    }
+
+    endGfxOperation();
+
+    if ( done != NULL ) {
+        done(context);
+    }
+    return 0;
+}
+
+void PixelsBase::waitTransfers() {
+    while ( isTransferring() ) {
+    }
+    if ( gfxOpNestingDepth == 0 && selectedChip == this ) {
+        deselectChip();
+    }
+}
+
+/*  -------   Antialiasing ------- */
+/* To be overriden with Pixels_Antialiasing.h */
+
+void PixelsBase::drawLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {}
+
+void PixelsBase::drawFatLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {}
+
+void PixelsBase::drawRoundRectangleAntialiased(int16_t x, int16_t y, int16_t width, int16_t height, int16_t rx, int16_t ry, boolean bordermode) {}
+
+void PixelsBase::drawCircleAntialiaced( int16_t x, int16_t y, int16_t radius, boolean bordermode )	{}
+
+/* TEXT */
+
+
+int PixelsBase::setFont(prog_uchar font[]) {
+    int16_t p1 = pgm_read_byte_near(font + 0);
+    int16_t p2 = pgm_read_byte_near(font + 1);
+    if ( p1 != 'Z' || p2 != 'F' ) {
+//			Serial.print("Invalid font prefix ");
+//			Serial.print( p1 );
+//			Serial.print( " " );
+//			Serial.println( p2 );
+        currentFont = NULL;
+        return -1;
+    }
+    int16_t fontType = pgm_read_byte_near(font + 2);
+    if ( fontType != ANTIALIASED_FONT && fontType != BITMASK_FONT ) {
+//			Serial.println("Unsupported font type");
+        currentFont = NULL;
+        return -1;
+    }
+    currentFont = font;
+#ifndef NO_GLYPH_INDEX
+    buildGlyphIndex();
+#endif
+    return 0;
+}
+
+#ifndef NO_GLYPH_INDEX
+void PixelsBase::buildGlyphIndex() {
+
+    glyphIndexLength = 0;
+
+    int16_t first = 0xff;
+    int16_t last = -1;
+
+    int16_t ptr = HEADER_LENGTH;
+    while ( 1 ) {
+        char cx = (char)(((int)pgm_read_byte_near(currentFont + ptr + 0) << 8) + pgm_read_byte_near(currentFont + ptr + 1));
+        if ( cx == 0 ) {
+          break;
+        }
+        int16_t length = (((int)(pgm_read_byte_near(currentFont + ptr + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(currentFont + ptr + 3) & 0xff));
+        if ( length < 8 ) {
+            // font corrupted
+            break;
+        }
+        uint8_t code = (uint8_t)cx;
+        if ( code < first ) {
+            first = code;
+        }
+        if ( code > last ) {
+            last = code;
+        }
+        ptr += length;
+    }
+
+    if ( last < first ) {
+        return;
+    }
+
+    uint16_t len = last - first + 1;
+    if ( len > glyphIndexCapacity ) {
+        if ( glyphIndex != NULL ) {
+            delete[] glyphIndex;
+        }
+        glyphIndex = new uint16_t[len];
+        if ( glyphIndex == NULL ) {
+            // not enough RAM: findGlyph() falls back to a font scan
+            glyphIndexCapacity = 0;
+            return;
+        }
+        glyphIndexCapacity = len;
+    }
+
+    for ( uint16_t i = 0; i < len; i++ ) {
+        glyphIndex[i] = 0;
+    }
+
+    ptr = HEADER_LENGTH;
+    while ( 1 ) {
+        char cx = (char)(((int)pgm_read_byte_near(currentFont + ptr + 0) << 8) + pgm_read_byte_near(currentFont + ptr + 1));
+        if ( cx == 0 ) {
+          break;
+        }
+        int16_t length = (((int)(pgm_read_byte_near(currentFont + ptr + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(currentFont + ptr + 3) & 0xff));
+        if ( length < 8 ) {
+            break;
+        }
+        uint16_t i = (uint8_t)cx - first;
+        if ( glyphIndex[i] == 0 ) {
+            glyphIndex[i] = ptr;
+        }
+        ptr += length;
+    }
+
+    glyphIndexFirst = first;
+    glyphIndexLength = len;
+}
+#endif
+
+prog_uchar* PixelsBase::findGlyph(char c) {
+    if ( currentFont == NULL ) {
+        return NULL;
+    }
+
+#ifndef NO_GLYPH_INDEX
+    if ( glyphIndexLength > 0 ) {
+        uint16_t i = (uint8_t)c - glyphIndexFirst;
+        if ( i >= glyphIndexLength || glyphIndex[i] == 0 ) {
+            return NULL;
+        }
+        return currentFont + glyphIndex[i];
+    }
+#endif
+
+    int16_t ptr = HEADER_LENGTH;
+    while ( 1 ) {
+        char cx = (char)(((int)pgm_read_byte_near(currentFont + ptr + 0) << 8) + pgm_read_byte_near(currentFont + ptr + 1));
+        if ( cx == 0 ) {
+          break;
+        }
+        int16_t length = (((int)(pgm_read_byte_near(currentFont + ptr + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(currentFont + ptr + 3) & 0xff));
+
+        if ( cx == c ) {
+            if ( length < 8 ) {
+//						Serial.print( "Invalid "  );
+//						Serial.print( c );
+//						Serial.println( " glyph definition. Font corrupted?" );
+                break;
+            }
+            return currentFont + ptr;
+        }
+        ptr += length;
+    }
+
+    return NULL;
+}
+
+void PixelsBase::print(int16_t xx, int16_t yy, const PixelsText& text, int8_t kerning[]) {
+    beginGfxOperation();
+    printString(xx, yy, text, 0, kerning);
+    endGfxOperation();
+}
+
+
+#ifndef NO_TEXT_WRAP
+uint16_t PixelsBase::layoutLine(const PixelsText& text, uint16_t start, int16_t x, int8_t kerning[],
+                                int16_t& kernPtr, int16_t& kern, TextLine& line) {
+
+    int16_t limit = width - textWrapMarginRight;
+    int16_t w = 0;
+
+    // the last word break: a space after a word
+    int16_t breakPos = -1;
+    int16_t breakWidth = 0;
+    int16_t breakKernPtr = 0;
+    int16_t breakKern = 0;
+
+    uint16_t end = text.length();
+    char prev = 0;
+    for ( uint16_t j = start; j < text.length(); j++ ) {
+        char c = text.charAt(j);
+        if ( c == '\n' ) {
+            end = j;
+            break;
+        }
+        if ( c == ' ' && prev != ' ' ) {
+            breakPos = j;
+            breakWidth = w;
+            breakKernPtr = kernPtr;
+            breakKern = kern;
+        }
+
+        prog_uchar* glyph = findGlyph(c);
+        boolean found = glyph != NULL;
+        int16_t glyphWidth = found ? 0xff & pgm_read_byte_near(glyph + 4) : 0;
+
+        // a glyph past the margin ends the line at the last word break or, within a single word, before the glyph.
+        // The first glyph of a line at the left margin stays, even if it does not fit
+        if ( found && x + w + glyphWidth > limit && (j > start || x > textWrapMarginLeft) ) {
+            if ( breakPos >= 0 ) {
+                end = breakPos;
+                w = breakWidth;
+                kernPtr = breakKernPtr;
+                kern = breakKern;
+            } else {
+                end = j;
+            }
+            break;
+        }
+
+        if ( kerning != NULL && kerning[kernPtr] > -100 ) {
             kern = kerning[kernPtr];
             if (kerning[kernPtr+1] > -100) {
                 kernPtr++;
@@ -1138,11 +1697,151 @@ void PixelsBase::printString(int16_t xx, int16_t yy, String text, boolean clean,
         }
 
         if ( found ) {
-            caretX += glyphWidth;
+            w += glyphWidth;
             if ( kern > -100 ) {
-                caretX += kern;
+                w += kern;
             }
         }
+        prev = c;
+    }
+
+    line.start = start;
+    line.end = end;
+    line.width = w;
+
+    // the spaces and line feeds the line is broken at are skipped
+    while ( end < text.length() && (text.charAt(end) == ' ' || text.charAt(end) == '\n') ) {
+        end++;
+    }
+    return end;
+}
+#endif
+
+int16_t PixelsBase::measureText(int16_t x, const PixelsText& text, TextLine lines[], int16_t maxLines, int8_t kerning[]) {
+    if ( currentFont == NULL || text.length() == 0 ) {
+        return 0;
+    }
+
+#ifndef NO_TEXT_WRAP
+    if ( wrapText ) {
+        int16_t kernPtr = 0;
+        int16_t kern = -100; // no kerning
+        int16_t count = 0;
+        TextLine line;
+        for ( uint16_t t = 0; t < text.length(); count++ ) {
+            t = layoutLine(text, t, count == 0 ? x : textWrapMarginLeft, kerning, kernPtr, kern, line);
+            if ( count < maxLines ) {
+                lines[count] = line;
+            }
+        }
+        return count;
+    }
+#endif
+
+    if ( maxLines > 0 ) {
+        lines[0].start = 0;
+        lines[0].end = text.length();
+        lines[0].width = getTextWidth(text, kerning);
+    }
+    return 1;
+}
+
+void PixelsBase::cleanText(int16_t xx, int16_t yy, const PixelsText& text, int8_t kerning[]) {
+    beginGfxOperation();
+    printString(xx, yy, text, 1, kerning);
+    endGfxOperation();
+}
+
+void PixelsBase::printString(int16_t xx, int16_t yy, const PixelsText& text, boolean clean, int8_t kerning[]) {
+
+    if ( currentFont == NULL ) {
+        return;
+    }
+
+    int16_t fontType = pgm_read_byte_near(currentFont + 2);
+    if ( fontType != ANTIALIASED_FONT && fontType != BITMASK_FONT ) {
+        return;
+    }
+
+    RGB* fg = foreground;
+
+    int16_t kernPtr = 0;
+    int16_t kern = -100; // no kerning
+
+    int16_t glyphHeight = pgm_read_byte_near(currentFont + 3);
+
+    caretX = xx;
+    caretY = yy;
+
+    int16_t glyphWidth = 0;
+
+#ifndef NO_TEXT_WRAP
+    boolean relOrigin = isOriginRelative();
+#endif
+
+    TextLine line;
+    uint16_t t = 0;
+    while ( t < text.length() ) {
+        uint16_t next = text.length();
+        line.end = text.length();
+#ifndef NO_TEXT_WRAP
+        if ( wrapText ) {
+            int16_t kp = kernPtr;
+            int16_t k = kern;
+            next = layoutLine(text, t, caretX, kerning, kp, k, line);
+        }
+#endif
+
+        for ( ; t < line.end; t++ ) {
+            char c = text.charAt(t);
+
+            prog_uchar* glyph = findGlyph(c);
+            boolean found = glyph != NULL;
+            if ( found ) {
+                int16_t length = (((int)(pgm_read_byte_near(glyph + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(glyph + 3) & 0xff));
+                glyphWidth = 0xff & pgm_read_byte_near(glyph + 4);
+                drawGlyph(fontType, clean, caretX, caretY, glyphHeight, glyph, length);
+            }
+
+            if ( kerning != NULL && kerning[kernPtr] > -100 ) {
+                kern = kerning[kernPtr];
+                if (kerning[kernPtr+1] > -100) {
+                    kernPtr++;
+                }
+            }
+
+            if ( found ) {
+                caretX += glyphWidth;
+                if ( kern > -100 ) {
+                    caretX += kern;
+                }
+            }
+        }
+        t = next;
+
+#ifndef NO_TEXT_WRAP
+        if ( t < text.length() ) {
+            caretX = textWrapMarginLeft;
+            caretY = caretY + glyphHeight + textWrapLineGap;
+            if ( textWrapScroll && (orientation == PORTRAIT_FLIP || orientation == PORTRAIT) &&
+                    caretY + glyphHeight + textWrapMarginBottom > height ) {
+
+                RGB* sav = NULL;
+                if ( textWrapScrollFill != NULL ) {
+                    sav = getBackground();
+                    setBackground(textWrapScrollFill);
+                }
+                finishScroll();
+                scroll(-(height - caretY - glyphHeight - textWrapMarginBottom), textWrapScrollSmooth ? SCROLL_SMOOTH | SCROLL_CLEAN : SCROLL_CLEAN);
+                if ( sav != NULL ) {
+                    setBackground(sav);
+                }
+                setOriginAbsolute();
+
+                caretY = height - glyphHeight - textWrapMarginBottom;
+            }
+        }
+#endif
     }
 
 #ifndef NO_TEXT_WRAP
@@ -1183,37 +1882,14 @@ int16_t PixelsBase::getTextBaseline() {
 }
 
 int16_t PixelsBase::getCharWidth(char c) {
-    if ( currentFont == NULL ) {
+    prog_uchar* glyph = findGlyph(c);
+    if ( glyph == NULL ) {
         return 0;
     }
-
-    int16_t ptr = HEADER_LENGTH;
-    while ( 1 ) {
-        char cx = (char)(((int)pgm_read_byte_near(currentFont + ptr + 0) << 8) + pgm_read_byte_near(currentFont + ptr + 1));
-        if ( cx == 0 ) {
-          break;
-        }
-        int16_t length = (((int)(pgm_read_byte_near(currentFont + ptr + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(currentFont + ptr + 3) & 0xff));
-
-        if ( cx == c ) {
-            if ( length < 8 ) {
-//						Serial.print( "Invalid "  );
-//						Serial.print( c );
-//						Serial.println( " glyph definition. Font corrupted?" );
-                break;
-            }
-//                Serial.print( c );
-
-            return 0xff & pgm_read_byte_near(currentFont + ptr + 4);
-        }
-
-        ptr += length;
-    }
-
-    return 0;
+    return 0xff & pgm_read_byte_near(glyph + 4);
 }
 
-int16_t PixelsBase::getTextWidth(String text, int8_t kerning[]) {
+int16_t PixelsBase::getTextWidth(const PixelsText& text, int8_t kerning[]) {
     if ( currentFont == NULL ) {
         return 0;
     }
@@ -1225,30 +1901,9 @@ int16_t PixelsBase::getTextWidth(String text, int8_t kerning[]) {
     for (uint16_t t = 0; t < text.length(); t++) {
         char c = text.charAt(t);
 
-        int16_t width = 0;
-        boolean found = false;
-        int16_t ptr = HEADER_LENGTH;
-        while ( 1 ) {
-            char cx = (char)(((int)pgm_read_byte_near(currentFont + ptr + 0) << 8) + pgm_read_byte_near(currentFont + ptr + 1));
-            if ( cx == 0 ) {
-              break;
-            }
-            int16_t length = (((int)(pgm_read_byte_near(currentFont + ptr + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(currentFont + ptr + 3) & 0xff));
-
-            if ( cx == c ) {
-                if ( length < 8 ) {
-//						Serial.print( "Invalid "  );
-//						Serial.print( c );
-//						Serial.println( " glyph definition. Font corrupted?" );
-                    break;
-                }
-//                Serial.print( c );
-                found = true;
-                width = 0xff & pgm_read_byte_near(currentFont + ptr + 4);
-            }
-
-            ptr += length;
-        }
+        prog_uchar* glyph = findGlyph(c);
+        boolean found = glyph != NULL;
+        int16_t width = found ? 0xff & pgm_read_byte_near(glyph + 4) : 0;
 
         if ( kerning != NULL && kerning[kernPtr] > -100 ) {
             kern = kerning[kernPtr];
@@ -1271,6 +1926,10 @@ int16_t PixelsBase::getTextWidth(String text, int8_t kerning[]) {
 void PixelsBase::drawGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t yy,
                            int16_t glyphHeight, prog_uchar* data, int16_t length) {
 
+    if ( blitGlyph(fontType, clean, xx, yy, glyphHeight, data, length) ) {
+        return;
+    }
+
     int16_t glyphWidth = 0xff & pgm_read_byte_near(data + 4);
     int16_t mLeft = 0x7f & pgm_read_byte_near(data + 5);
     int16_t mTop = 0xff & pgm_read_byte_near(data + 6);
@@ -1284,6 +1943,16 @@ void PixelsBase::drawGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t
     RGB* fg = foreground;
     RGB* bg = background;
 
+    // antialiased pixels repeat few opacity levels: the blended color is computed on a change only
+    int16_t lastOpacity = -1;
+    RGB* cl = fg;
+#ifndef PIXELS_MONOCHROME
+    // over a transparent background they are blended with the video memory if that can be read
+    boolean blendInk = !clean && glyphPrintMode != FILL_TEXT_BACKGROUND && canReadBack();
+#else
+    boolean blendInk = false;
+#endif
+
     int16_t ctr = 0;
 #ifndef NO_FILL_TEXT_BACKGROUND
     int16_t prev = -1;
@@ -1421,12 +2090,18 @@ void PixelsBase::drawGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t
                 } else if (fontType == ANTIALIASED_FONT) {
                     if ( clean ) {
                         setColor(bg);
+                        drawPixel(x, y);
+                    } else if ( blendInk ) {
+                        putColor(x, y, false, 0xff - (0xff & (b << 2)));
                     } else {
                         uint8_t opacity = (0xff & (b << 2));
-                        RGB* cl = computeColor(fg, opacity);
+                        if ( opacity != lastOpacity ) {
+                            cl = computeColor(fg, opacity);
+                            lastOpacity = opacity;
+                        }
                         setColor(cl);
+                        drawPixel(x, y);
                     }
-                    drawPixel(x, y);
                     ctr++;
                 }
 #ifndef NO_FILL_TEXT_BACKGROUND
@@ -1475,43 +2150,242 @@ void PixelsBase::drawGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t
             }
 #endif
 
-            for ( uint8_t j = 0; j < 8; j++ ) {
-                if ( x + j == effWidth ) {
-                    x = -j;
-                    y++;
-#ifndef NO_FILL_TEXT_BACKGROUND
-                    if ( glyphPrintMode == FILL_TEXT_BACKGROUND && prev != y ) {
-                        setColor(bg);
-                        hLine(xx, offsetTop + y, hEdge);
-                        if ( !clean ) {
-                            setColor(fg);
-                        }
-                        prev = y;
-                    }
+            for ( uint8_t j = 0; j < 8; j++ ) {
+                if ( x + j == effWidth ) {
+                    x = -j;
+                    y++;
+#ifndef NO_FILL_TEXT_BACKGROUND
+                    if ( glyphPrintMode == FILL_TEXT_BACKGROUND && prev != y ) {
+                        flushPixels();
+                        setColor(bg);
+                        hLine(xx, offsetTop + y, hEdge);
+                        if ( !clean ) {
+                            setColor(fg);
+                        }
+                        prev = y;
+                    }
+#endif
+                }
+                int mask = 1 << (7 - j);
+                if ( (b & mask) == 0 ) {
+                    bufferPixel(offsetLeft + x + j, offsetTop + y);
+                }
+            }
+#ifndef NO_FILL_TEXT_BACKGROUND
+            last = y;
+#endif
+        }
+        flushPixels();
+
+#ifndef NO_FILL_TEXT_BACKGROUND
+        if ( glyphPrintMode == FILL_TEXT_BACKGROUND ) {
+            setColor(bg);
+            fillRectangle(xx, offsetTop + last + 1, glyphWidth + 1, glyphHeight - mTop - last);
+        }
+#endif
+    }
+
+    setColor(fg);
+}
+
+boolean PixelsBase::blitGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t yy,
+                           int16_t glyphHeight, prog_uchar* data, int16_t length) {
+
+#if GLYPH_BUFFER_SIZE > 0
+    int16_t glyphWidth = 0xff & pgm_read_byte_near(data + 4);
+    if ( glyphWidth <= 0 || glyphHeight <= 0 || (int32_t)glyphWidth * glyphHeight > GLYPH_BUFFER_SIZE ) {
+        // the glyph is rendered run by run with drawGlyph()
+        return false;
+    }
+
+    int16_t mLeft = 0x7f & pgm_read_byte_near(data + 5);
+    int16_t mTop = 0xff & pgm_read_byte_near(data + 6);
+    int16_t mRight = 0x7f & pgm_read_byte_near(data + 7);
+
+    boolean vraster = (0x80 & pgm_read_byte_near(data + 5)) > 0;
+    boolean compressed = (pgm_read_byte_near(data + 7) & 0x80) > 0;
+
+    int16_t eff = vraster ?
+            glyphHeight - mTop - mRight :
+            glyphWidth - mLeft - mRight;
+    int16_t lines = vraster ? glyphWidth - mLeft : glyphHeight - mTop;
+    if ( eff <= 0 || lines <= 0 ) {
+        return false;
+    }
+
+    // glyph raster decoded to per-pixel coverage: 0 - no ink, 0xff - full ink, other values - antialiased ink
+    int16_t size = eff * lines;
+    uint8_t coverage[GLYPH_BUFFER_SIZE];
+    memset(coverage, 0, size);
+
+    length -= 8;
+
+    if ( fontType == BITMASK_FONT && !compressed ) {
+        for ( int16_t i = 0; i < length; i++ ) {
+            int16_t b = 0xff & pgm_read_byte_near(data + 8 + i);
+            for ( uint8_t j = 0; j < 8; j++ ) {
+                int16_t ctr = i * 8 + j;
+                if ( ctr < size && (b & (1 << (7 - j))) == 0 ) {
+                    coverage[ctr] = 0xff;
+                }
+            }
+        }
+    } else {
+        int16_t ctr = 0;
+        for ( int16_t i = 0; i < length; i++ ) {
+            int16_t b = 0xff & pgm_read_byte_near(data + 8 + i);
+            int16_t len;
+            uint8_t value;
+            if ( fontType == BITMASK_FONT ) {
+                len = 0x7f & b;
+                value = (0x80 & b) > 0 ? 0xff : 0;
+            } else if ( (0xc0 & b) > 0 ) {
+                len = 0x3f & b;
+                value = (0x80 & b) > 0 ? 0xff : 0;
+            } else {
+                len = 1;
+                value = 0xff - (0xff & (b << 2));
+            }
+            if ( value != 0 ) {
+                for ( int16_t j = ctr; j < ctr + len && j < size; j++ ) {
+                    coverage[j] = value;
+                }
+            }
+            ctr += len;
+        }
+    }
+
+    int16_t offsetLeft = mLeft + xx;
+    int16_t offsetTop = mTop + yy;
+
+#ifndef NO_FILL_TEXT_BACKGROUND
+    if ( glyphPrintMode == FILL_TEXT_BACKGROUND ) {
+        blitCoverage(Bounds(xx, yy, xx + glyphWidth - 1, yy + glyphHeight - 1), coverage,
+                     offsetLeft, offsetTop, eff, lines, vraster, clean);
+        return true;
+    }
+#endif
+
+    // transparent background: every horizontal ink span goes to its own window. Antialiased ink is
+    // blended with the video memory under it if that can be read, else with the background color
+#ifndef PIXELS_MONOCHROME
+    boolean readBack = !clean && canReadBack();
 #endif
-                }
-                int mask = 1 << (7 - j);
-                if ( (b & mask) == 0 ) {
-                    drawPixel(offsetLeft + x + j, offsetTop + y);
+    for ( int16_t y = 0; y < glyphHeight; y++ ) {
+        int16_t start = -1;
+        boolean partial = false;
+        for ( int16_t x = 0; x <= glyphWidth; x++ ) {
+            uint8_t value = 0;
+            if ( x < glyphWidth ) {
+                int16_t line = vraster ? x - mLeft : y - mTop;
+                int16_t pos = vraster ? y - mTop : x - mLeft;
+                if ( line >= 0 && line < lines && pos >= 0 && pos < eff ) {
+                    value = coverage[line * eff + pos];
                 }
             }
-#ifndef NO_FILL_TEXT_BACKGROUND
-            last = y;
+            if ( value != 0 && start < 0 ) {
+                start = x;
+                partial = false;
+            }
+            if ( value != 0 ) {
+                partial |= value != 0xff;
+            } else if ( start >= 0 ) {
+#ifndef PIXELS_MONOCHROME
+                if ( readBack && partial ) {
+                    blendGlyphSpan(xx + start, yy + y, xx + x - 1, coverage, offsetLeft, offsetTop, eff, vraster);
+                    start = -1;
+                    continue;
+                }
 #endif
+                blitCoverage(Bounds(xx + start, yy + y, xx + x - 1, yy + y), coverage,
+                             offsetLeft, offsetTop, eff, lines, vraster, clean);
+                start = -1;
+            }
         }
+    }
 
-#ifndef NO_FILL_TEXT_BACKGROUND
-        if ( glyphPrintMode == FILL_TEXT_BACKGROUND ) {
-            setColor(bg);
-            fillRectangle(xx, offsetTop + last + 1, glyphWidth + 1, glyphHeight - mTop - last);
-        }
+    return true;
+#else
+    return false;
 #endif
+}
+
+#ifndef PIXELS_MONOCHROME
+void PixelsBase::blendGlyphSpan(int16_t x1, int16_t y, int16_t x2, uint8_t* coverage, int16_t offsetLeft, int16_t offsetTop,
+                                int16_t eff, boolean vraster) {
+
+    // the span is inside the glyph raster: its coverage needs no bounds check
+    uint8_t alpha[BLEND_BUFFER_SIZE];
+    for ( int16_t x = x1; x <= x2; x += BLEND_BUFFER_SIZE ) {
+        int16_t end = min(x2, x + BLEND_BUFFER_SIZE - 1);
+        for ( int16_t i = x; i <= end; i++ ) {
+            int16_t line = vraster ? i - offsetLeft : y - offsetTop;
+            int16_t pos = vraster ? y - offsetTop : i - offsetLeft;
+            alpha[i - x] = coverage[line * eff + pos];
+        }
+        blendTile(x, y, end, y, alpha, end - x + 1);
     }
+}
+#endif
 
-    setColor(fg);
+void PixelsBase::blitCoverage(Bounds bb, uint8_t* coverage, int16_t offsetLeft, int16_t offsetTop,
+                              int16_t eff, int16_t lines, boolean vraster, boolean clean) {
+
+    uint16_t fg = clean ? backgroundColor : foregroundColor;
+    uint16_t bg = backgroundColor;
+
+    uint8_t lastValue = 0xff;
+    uint16_t lastColor = fg;
+
+    // pixels are passed to the driver a chunk at a time rather than with a device call each
+    uint16_t chunk[PIXEL_CHUNK_SIZE];
+    uint8_t chunkLength = 0;
+
+    WindowScan scan;
+    for ( uint8_t part = 0; part < 2; part++ ) {
+        if ( !openWindow(bb, part, scan) ) {
+            continue;
+        }
+
+        int16_t rx = scan.x;
+        int16_t ry = scan.y;
+        for ( int16_t r = 0; r < scan.rows; r++ ) {
+            int16_t x = rx;
+            int16_t y = ry;
+            for ( int16_t c = 0; c < scan.cols; c++ ) {
+                int16_t line = vraster ? x - offsetLeft : y - offsetTop;
+                int16_t pos = vraster ? y - offsetTop : x - offsetLeft;
+                uint8_t value = line >= 0 && line < lines && pos >= 0 && pos < eff ? coverage[line * eff + pos] : 0;
+
+                if ( value == 0 ) {
+                    chunk[chunkLength++] = bg;
+                } else if ( value == 0xff || clean ) {
+                    chunk[chunkLength++] = fg;
+                } else {
+                    if ( value != lastValue ) {
+                        lastValue = value;
+                        lastColor = computeColor(foreground, (uint8_t)(0xff - value))->convertTo565();
+                    }
+                    chunk[chunkLength++] = lastColor;
+                }
+                if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+                    deviceWritePixels(chunk, chunkLength);
+                    chunkLength = 0;
+                }
+
+                x += scan.colDx;
+                y += scan.colDy;
+            }
+            rx += scan.rowDx;
+            ry += scan.rowDy;
+        }
+        // the second part opens another window
+        deviceWritePixels(chunk, chunkLength);
+        chunkLength = 0;
+    }
 }
 
-void PixelsBase::scrollText( int16_t x, int16_t y, String text, uint8_t scrollStep, uint8_t repeat, uint16_t maxScroll ) {
+void PixelsBase::scrollText( int16_t x, int16_t y, const PixelsText& text, uint8_t scrollStep, uint8_t repeat, uint16_t maxScroll ) {
 
     int extraRowDelay = 0; // increase to slow down
 
@@ -1590,7 +2464,7 @@ void PixelsBase::scrollText( int16_t x, int16_t y, String text, uint8_t scrollSt
                 e = text.length();
             }
 
-            String s = text.substring(p, e);
+            PixelsText s = text.substring(p, e);
             int q = (x + xx) % getWidth();
 
             if ( q != 0 || x != getWidth() || getScroll() != 0 ) {
@@ -1653,10 +2527,165 @@ void PixelsBase::scrollText( int16_t x, int16_t y, String text, uint8_t scrollSt
     } while ( repeat == 0 || repeat > 1 );
 }
 
+void PixelsBase::beginMarquee(int16_t y, const PixelsText& text, uint8_t scrollStep, uint16_t stepMs, uint8_t repeat) {
+    finishScroll();
+    marqueeRunning = false;
+    if ( !canScroll() || currentFont == NULL || scrollStep == 0 ) {
+        return;
+    }
+
+    if ( getOrientation() % 2 == 0 ) {
+        setOrientation(LANDSCAPE);
+    }
+
+    marqueeText = text;
+    marqueeY = y;
+    marqueeStep = scrollStep;
+    marqueeRepeat = repeat;
+    marqueeInterval = stepMs;
+    marqueeChar = 0;
+    marqueeColumn = 0;
+    marqueeLast = millis();
+    marqueeRunning = true;
+}
+
+void PixelsBase::stepMarquee() {
+    int16_t fontType = pgm_read_byte_near(currentFont + 2);
+    int16_t glyphHeight = pgm_read_byte_near(currentFont + 3);
+
+    scroll(marqueeStep, 0);
+
+    beginGfxOperation();
+    boolean savorigin = relativeOrigin;
+    relativeOrigin = false;
+
+    // the text columns following the glyph cursor enter at the right screen edge
+    int16_t x = width - marqueeStep;
+    while ( x < width ) {
+        if ( marqueeChar < marqueeText.length() ) {
+            prog_uchar* glyph = findGlyph(marqueeText.charAt(marqueeChar));
+            int16_t glyphWidth = glyph == NULL ? 0 : 0xff & pgm_read_byte_near(glyph + 4);
+            if ( marqueeColumn >= glyphWidth ) {
+                marqueeChar++;
+                marqueeColumn = 0;
+                continue;
+            }
+            int16_t n = min(width - x, glyphWidth - marqueeColumn);
+            int16_t length = (((int)(pgm_read_byte_near(glyph + 2) & 0xff) << 8) + (int)(pgm_read_byte_near(glyph + 3) & 0xff));
+            drawGlyphColumns(fontType, x, marqueeY, glyphHeight, glyph, length, marqueeColumn, n);
+            marqueeColumn += n;
+            x += n;
+        } else {
+            // blank columns until the text has scrolled out
+            int16_t n = min(width - x, width - marqueeColumn);
+            RGB* sav = getColor();
+            setColor(background);
+            fillRectangle(x, marqueeY, n, glyphHeight);
+            setColor(sav);
+            marqueeColumn += n;
+            x += n;
+            if ( marqueeColumn >= width ) {
+                marqueeChar = 0;
+                marqueeColumn = 0;
+                if ( marqueeRepeat > 0 && --marqueeRepeat == 0 ) {
+                    marqueeRunning = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    relativeOrigin = savorigin;
+    endGfxOperation();
+}
+
+// marquee slices share the glyph buffer size, with a small floor when glyph windows are disabled
+#if GLYPH_BUFFER_SIZE >= 32
+#define GLYPH_SLICE_SIZE GLYPH_BUFFER_SIZE
+#else
+#define GLYPH_SLICE_SIZE 32
+#endif
+
+void PixelsBase::drawGlyphColumns(int16_t fontType, int16_t x, int16_t yy, int16_t glyphHeight,
+                               prog_uchar* data, int16_t length, int16_t column, int16_t columns) {
+
+    // wide slices go in parts and tall ones in bands, so the coverage buffer stays within GLYPH_SLICE_SIZE
+    int16_t bandRows = min(glyphHeight, (int16_t)GLYPH_SLICE_SIZE);
+    int16_t maxColumns = GLYPH_SLICE_SIZE / bandRows;
+    while ( columns > maxColumns ) {
+        drawGlyphColumns(fontType, x, yy, glyphHeight, data, length, column, maxColumns);
+        x += maxColumns;
+        column += maxColumns;
+        columns -= maxColumns;
+    }
+
+    int16_t mLeft = 0x7f & pgm_read_byte_near(data + 5);
+    int16_t mTop = 0xff & pgm_read_byte_near(data + 6);
+    int16_t mRight = 0x7f & pgm_read_byte_near(data + 7);
+
+    boolean vraster = (0x80 & pgm_read_byte_near(data + 5)) > 0;
+    boolean compressed = (pgm_read_byte_near(data + 7) & 0x80) > 0;
+
+    int16_t glyphWidth = 0xff & pgm_read_byte_near(data + 4);
+    int16_t eff = vraster ?
+            glyphHeight - mTop - mRight :
+            glyphWidth - mLeft - mRight;
+    int16_t lines = vraster ? glyphWidth - mLeft : glyphHeight - mTop;
+    int16_t size = eff * lines;
+
+    // the slice coverage goes column by column, bandRows values each (see blitGlyph())
+    uint8_t coverage[GLYPH_SLICE_SIZE];
+
+    length -= 8;
+
+    boolean bits = fontType == BITMASK_FONT && !compressed;
+    for ( int16_t r0 = 0; r0 < glyphHeight; r0 += bandRows ) {
+        int16_t rows = min(bandRows, (int16_t)(glyphHeight - r0));
+        memset(coverage, 0, columns * rows);
+
+        int16_t ctr = 0;
+        for ( int16_t i = 0; i < length && eff > 0 && ctr < size; i++ ) {
+            int16_t b = 0xff & pgm_read_byte_near(data + 8 + i);
+            int16_t len;
+            uint8_t value;
+            if ( bits ) {
+                len = 8;
+                value = 0xff;
+            } else if ( fontType == BITMASK_FONT ) {
+                len = 0x7f & b;
+                value = (0x80 & b) > 0 ? 0xff : 0;
+            } else if ( (0xc0 & b) > 0 ) {
+                len = 0x3f & b;
+                value = (0x80 & b) > 0 ? 0xff : 0;
+            } else {
+                len = 1;
+                value = 0xff - (0xff & (b << 2));
+            }
+            if ( value != 0 ) {
+                for ( int16_t j = 0; j < len && ctr + j < size; j++ ) {
+                    if ( bits && (b & (0x80 >> j)) != 0 ) {
+                        continue;
+                    }
+                    int16_t line = (ctr + j) / eff;
+                    int16_t pos = (ctr + j) % eff;
+                    int16_t c = (vraster ? mLeft + line : mLeft + pos) - column;
+                    int16_t r = (vraster ? mTop + pos : mTop + line) - r0;
+                    if ( c >= 0 && c < columns && r >= 0 && r < rows ) {
+                        coverage[c * rows + r] = value;
+                    }
+                }
+            }
+            ctr += len;
+        }
+
+        blitCoverage(Bounds(x, yy + r0, x + columns - 1, yy + r0 + rows - 1), coverage,
+                     x, yy + r0, rows, columns, true, false);
+    }
+}
 
 /* Low level */
 
-void PixelsBase::putColor(int16_t x, int16_t y, boolean steep, double alpha) {
+void PixelsBase::putColor(int16_t x, int16_t y, boolean steep, uint8_t alpha) {
 
     if ( steep ) {
         int16_t tmp = x;
@@ -1664,14 +2693,20 @@ void PixelsBase::putColor(int16_t x, int16_t y, boolean steep, double alpha) {
         y = tmp;
     }
 
-    if ( x < 0 || x >= width || y < 0 || y >= height ) {
+    if ( alpha == 0 || x < 0 || x >= width || y < 0 || y >= height ) {
         return;
     }
 
-    RGB* result;
-    if ( alpha != 1 ) {
-        RGB* bg = getPixel(x, y);
-        result = computeColor(bg, alpha);
+#ifdef PIXELS_MONOCHROME
+    // no blending: a pixel is covered or not
+    if ( alpha >= 0x80 ) {
+        drawPixel(x, y);
+    }
+#else
+    if ( alpha != 0xff ) {
+        // a bus that cannot read blends with the background color
+        RGB* bg = canReadBack() ? getPixel(x, y) : getBackground();
+        RGB* result = blendColor(bg, alpha);
         RGB* sav = getColor();
         setColor(result);
         drawPixel(x, y);
@@ -1679,25 +2714,108 @@ void PixelsBase::putColor(int16_t x, int16_t y, boolean steep, double alpha) {
     } else {
         drawPixel(x, y);
     }
+#endif
+}
+
+
+void PixelsBase::blendRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t* alpha) {
+
+    int16_t w = x2 - x1 + 1;
+
+    // the region goes in tiles fitting the read back buffer
+    int16_t tileWidth = w < BLEND_BUFFER_SIZE ? w : BLEND_BUFFER_SIZE;
+    int16_t tileHeight = BLEND_BUFFER_SIZE / tileWidth;
+    for ( int16_t y = y1; y <= y2; y += tileHeight ) {
+        for ( int16_t x = x1; x <= x2; x += tileWidth ) {
+            blendTile(x, y, min(x + tileWidth - 1, x2), min(y + tileHeight - 1, y2),
+                      alpha + (int32_t)(y - y1) * w + x - x1, w);
+        }
+    }
 }
 
+void PixelsBase::blendTile(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t* alpha, int16_t stride) {
 
-RGB* PixelsBase::computeColor(RGB* bg, double alpha) {
-    if ( alpha < 0 ) {
-        alpha = 0;
-        return bg;
+    int16_t w = x2 - x1 + 1;
+    int16_t size = w * (y2 - y1 + 1);
+
+#ifdef PIXELS_MONOCHROME
+    // nothing to blend with: the video memory is not read
+    for ( int16_t i = 0; i < size; i++ ) {
+        putColor(x1 + i % w, y1 + i / w, false, alpha[i / w * stride + i % w]);
+    }
+#else
+    uint16_t buf[BLEND_BUFFER_SIZE];
+
+    if ( !readRegion(x1, y1, x2, y2, buf) ) {
+        for ( int16_t i = 0; i < size; i++ ) {
+            putColor(x1 + i % w, y1 + i / w, false, alpha[i / w * stride + i % w]);
+        }
+        return;
+    }
+
+    for ( int16_t i = 0; i < size; i++ ) {
+        uint8_t a = alpha[i / w * stride + i % w];
+        if ( a != 0 ) {
+            RGB bg = pixelBuffer->convert565toRGB(buf[i]);
+            buf[i] = blendColor(&bg, a)->convertTo565();
+        }
     }
-    if ( alpha > 1 ) {
-        alpha = 1;
+
+    beginGfxOperation();
+
+    uint16_t chunk[PIXEL_CHUNK_SIZE];
+    uint8_t chunkLength = 0;
+
+    Bounds bb(x1, y1, x2, y2);
+    WindowScan scan;
+    for ( uint8_t part = 0; part < 2; part++ ) {
+        if ( !openWindow(bb, part, scan) ) {
+            continue;
+        }
+
+        int16_t rx = scan.x;
+        int16_t ry = scan.y;
+        for ( int16_t r = 0; r < scan.rows; r++ ) {
+            int16_t x = rx;
+            int16_t y = ry;
+            for ( int16_t c = 0; c < scan.cols; c++ ) {
+                chunk[chunkLength++] = buf[(int32_t)(y - y1) * w + x - x1];
+                if ( chunkLength == PIXEL_CHUNK_SIZE ) {
+                    deviceWritePixels(chunk, chunkLength);
+                    chunkLength = 0;
+                }
+                x += scan.colDx;
+                y += scan.colDy;
+            }
+            rx += scan.rowDx;
+            ry += scan.rowDy;
+        }
+        deviceWritePixels(chunk, chunkLength);
+        chunkLength = 0;
     }
-    computedBgColor->setColor( (int32_t)(bg->red * (1 - alpha) + foreground->red * alpha),
-        (int32_t)(bg->green * (1 - alpha) + foreground->green * alpha),
-        (int32_t)(bg->blue * (1 - alpha) + foreground->blue * alpha));
+
+    endGfxOperation();
+#endif
+}
+
+RGB* PixelsBase::blendColor(RGB* bg, uint8_t alpha) {
+#ifdef PIXELS_MONOCHROME
+    return alpha >= 0x80 ? foreground : bg;
+#else
+    uint8_t ialpha = 0xff - alpha;
+    computedBgColor->setColor( ((uint16_t)bg->red * ialpha + (uint16_t)foreground->red * alpha) / 255,
+        ((uint16_t)bg->green * ialpha + (uint16_t)foreground->green * alpha) / 255,
+        ((uint16_t)bg->blue * ialpha + (uint16_t)foreground->blue * alpha) / 255);
 
     return computedBgColor;
+#endif
 }
 
 RGB* PixelsBase::computeColor(RGB* fg, uint8_t opacity) {
+#ifdef PIXELS_MONOCHROME
+    // opacity is the background share
+    return opacity < 0x80 ? fg : background;
+#else
     int32_t sr = (int32_t)fg->red * (255 - opacity) + background->red * opacity;
     int32_t sg = (int32_t)fg->green * (255 - opacity) + background->green * opacity;
     int32_t sb = (int32_t)fg->blue * (255 - opacity) + background->blue * opacity;
@@ -1716,6 +2834,7 @@ RGB* PixelsBase::computeColor(RGB* fg, uint8_t opacity) {
     computedFgColor->setColor(sr, sg, sb);
 
     return computedFgColor;
+#endif
 }
 
 void PixelsBase::scroll(int16_t dy, int8_t flags) {
@@ -1732,30 +2851,22 @@ void PixelsBase::scroll(int16_t dy, int16_t x1, int16_t x2, int8_t flags) {
 
     if (mdy > 1 && (flags & SCROLL_SMOOTH) > 0) {
 
+        // the movement takes as long as line by line steps with eased delays used to
         int16_t easingLen = 8;
         if ( mdy / 2 < easingLen) {
             easingLen = mdy / 2;
         }
 
         int16_t dlx = (flags & SCROLL_CLEAN) > 0 ? 0 : 7;
-        int16_t factor = 1;
 
-        int16_t step = dy < 0 ? -1 : 1;
-        for ( int16_t i = 0; i < easingLen; i++ ) {
-            delay(dlx+(easingLen-i)*(easingLen-i)*factor/2+extraScrollDelay);
-            scroll(step, x1, x2, flags & SCROLL_CLEAN);
-        }
-        for ( int16_t i = 0; i < mdy - easingLen*2; i++ ) {
-            scroll(step, x1, x2, flags & SCROLL_CLEAN);
-            if ( mdy > 150 ) {
-                delay(factor);
-            } else {
-                delay(dlx+factor+extraScrollDelay);
-            }
-        }
+        uint32_t duration = (uint32_t)(mdy - easingLen * 2) * (mdy > 150 ? 1 : dlx + 1 + extraScrollDelay);
         for ( int16_t i = 1; i <= easingLen; i++ ) {
-            scroll(step, x1, x2, flags & SCROLL_CLEAN);
-            delay(dlx+i*i*factor/2+extraScrollDelay);
+            duration += 2 * (dlx + i * i / 2 + extraScrollDelay);
+        }
+
+        startScroll(dy, flags, duration > 0xffff ? 0xffff : duration);
+        while ( advanceScroll(millis()) ) {
+            delay(1);
         }
 
     } else {
@@ -1798,6 +2909,59 @@ void PixelsBase::scroll(int16_t dy, int16_t x1, int16_t x2, int8_t flags) {
     }
 }
 
+void PixelsBase::startScroll(int16_t dy, int8_t flags, uint16_t durationMs) {
+    finishScroll();
+    if ( !canScroll() || dy == 0 ) {
+        return;
+    }
+
+    scrolling = true;
+    scrollFlags = flags;
+    scrollDistance = dy;
+    scrollDone = 0;
+    scrollDuration = durationMs;
+    scrollStart = millis();
+}
+
+boolean PixelsBase::tick(unsigned long nowMs) {
+    if ( marqueeRunning && nowMs - marqueeLast >= marqueeInterval ) {
+        // a late step does not make the following ones come faster
+        marqueeLast = nowMs - marqueeLast >= 2 * (unsigned long)marqueeInterval ? nowMs : marqueeLast + marqueeInterval;
+        stepMarquee();
+    }
+    return advanceScroll(nowMs) || marqueeRunning;
+}
+
+boolean PixelsBase::advanceScroll(unsigned long nowMs) {
+    if ( !scrolling ) {
+        return false;
+    }
+
+    int16_t target = scrollDistance;
+    unsigned long elapsed = nowMs - scrollStart;
+    if ( elapsed < scrollDuration ) {
+        // progress in 1/1024 of the movement, eased with smoothstep (3u^2 - 2u^3)
+        uint32_t u = (uint32_t)elapsed * 1024 / scrollDuration;
+        if ( (scrollFlags & SCROLL_SMOOTH) > 0 ) {
+            u = (u * u * (3 * 1024 - 2 * u)) >> 20;
+        }
+        target = (int32_t)scrollDistance * (int32_t)u / 1024;
+    }
+
+    if ( target != scrollDone ) {
+        scroll(target - scrollDone, scrollFlags & SCROLL_CLEAN);
+        scrollDone = target;
+    }
+
+    scrolling = scrollDone != scrollDistance;
+    return scrolling;
+}
+
+void PixelsBase::finishScroll() {
+    if ( scrolling ) {
+        advanceScroll(scrollStart + scrollDuration);
+    }
+}
 
 void PixelsBase::drawPixel(int16_t x, int16_t y) {
 
@@ -1860,12 +3024,214 @@ void PixelsBase::drawPixel(int16_t x, int16_t y) {
         yy %= deviceHeight;
     }
 
+    devicePixel(xx, yy, foregroundColor);
+}
+
+void PixelsBase::drawPixels(const int16_t* xy, uint16_t n) {
     beginGfxOperation();
-    setRegion(xx, yy, xx, yy);
-    setCurrentPixel(foreground);
+    for ( uint16_t i = 0; i < n; i++ ) {
+        bufferPixel(xy[2 * i], xy[2 * i + 1]);
+    }
+    flushPixels();
     endGfxOperation();
 }
 
+void PixelsBase::bufferPixel(int16_t x, int16_t y) {
+#if PIXEL_BUFFER_SIZE > 0
+    if ( x < 0 || y < 0 || x >= width || y >= height ) {
+        return;
+    }
+    if ( pointBufferLength == PIXEL_BUFFER_SIZE ) {
+        flushPixels();
+    }
+    pointBuffer[2 * pointBufferLength] = x;
+    pointBuffer[2 * pointBufferLength + 1] = y;
+    pointBufferLength++;
+#else
+    drawPixel(x, y);
+#endif
+}
+
+#if PIXEL_BUFFER_SIZE > 0
+/* insertion sort of n points by the major, then by the minor coordinate (0 - x, 1 - y) */
+static void sortPoints(int16_t* p, uint8_t n, uint8_t major) {
+    uint8_t minor = 1 - major;
+    for ( uint8_t i = 1; i < n; i++ ) {
+        int16_t x = p[2 * i];
+        int16_t y = p[2 * i + 1];
+        int16_t a = major == 0 ? x : y;
+        int16_t b = major == 0 ? y : x;
+        uint8_t j = i;
+        while ( j > 0 && (p[2 * j - 2 + major] > a || (p[2 * j - 2 + major] == a && p[2 * j - 2 + minor] > b)) ) {
+            p[2 * j] = p[2 * j - 2];
+            p[2 * j + 1] = p[2 * j - 1];
+            j--;
+        }
+        p[2 * j] = x;
+        p[2 * j + 1] = y;
+    }
+}
+#endif
+
+void PixelsBase::flushPixels() {
+#if PIXEL_BUFFER_SIZE > 0
+    uint8_t n = pointBufferLength;
+    if ( n == 0 ) {
+        return;
+    }
+    pointBufferLength = 0;
+
+    int16_t* p = pointBuffer;
+    int color = foregroundColor;
+
+    // horizontal runs first. Points left alone are moved to the buffer head
+    sortPoints(p, n, 1);
+    uint8_t singles = 0;
+    uint8_t i = 0;
+    while ( i < n ) {
+        int16_t x1 = p[2 * i];
+        int16_t y = p[2 * i + 1];
+        int16_t x2 = x1;
+        i++;
+        while ( i < n && p[2 * i + 1] == y && p[2 * i] <= x2 + 1 ) {
+            x2 = p[2 * i];
+            i++;
+        }
+        if ( x2 > x1 ) {
+            fill(color, x1, y, x2, y);
+        } else {
+            p[2 * singles] = x1;
+            p[2 * singles + 1] = y;
+            singles++;
+        }
+    }
+
+    // vertical runs of the rest
+    sortPoints(p, singles, 0);
+    i = 0;
+    while ( i < singles ) {
+        int16_t x = p[2 * i];
+        int16_t y1 = p[2 * i + 1];
+        int16_t y2 = y1;
+        i++;
+        while ( i < singles && p[2 * i] == x && p[2 * i + 1] <= y2 + 1 ) {
+            y2 = p[2 * i + 1];
+            i++;
+        }
+        fill(color, x, y1, x, y2);
+    }
+#endif
+}
+
+boolean PixelsBase::openWindow(Bounds bb, uint8_t part, WindowScan& scan, boolean read) {
+
+    if ( bb.x1 < 0 ) {
+        bb.x1 = 0;
+    }
+    if ( bb.y1 < 0 ) {
+        bb.y1 = 0;
+    }
+    if ( bb.x2 >= width ) {
+        bb.x2 = width - 1;
+    }
+    if ( bb.y2 >= height ) {
+        bb.y2 = height - 1;
+    }
+    if ( bb.x1 > bb.x2 || bb.y1 > bb.y2 ) {
+        return false;
+    }
+
+    Bounds db = bb;
+    transformBounds(db);
+
+    int16_t s = 0;
+    if ( !relativeOrigin ) {
+        s = orientation > 1 ? (deviceHeight - currentScroll) % deviceHeight : currentScroll;
+        db.y1 += s;
+        db.y2 += s;
+        if ( db.y1 >= deviceHeight ) {
+            db.y1 -= deviceHeight;
+            db.y2 -= deviceHeight;
+            s -= deviceHeight;
+        }
+    }
+
+    if ( db.y2 >= deviceHeight ) {
+        // the window wraps around video memory bottom
+        if ( part == 0 ) {
+            db.y2 = deviceHeight - 1;
+        } else {
+            db.y1 = 0;
+            db.y2 -= deviceHeight;
+            s -= deviceHeight;
+        }
+    } else if ( part > 0 ) {
+        return false;
+    }
+
+    if( !checkBounds(db) ) {
+        return false;
+    }
+
+    boolean oriented = false;
+    if ( read ) {
+        if ( !beginReadRegion(db.x1, db.y1, db.x2, db.y2) ) {
+            return false;
+        }
+    } else if ( orientRegion(db.x1, db.y1, db.x2, db.y2) ) {
+        oriented = true;
+    } else if ( setRegion(db.x1, db.y1, db.x2, db.y2) == 0 ) {
+        return false;
+    }
+
+    db.y1 -= s;
+    db.y2 -= s;
+
+    if ( oriented ) {
+        // the controller scans the window in logical order, as it does by portrait orientation
+        untransformBounds(db);
+    }
+
+    switch( oriented ? PORTRAIT : orientation ) {
+    case PORTRAIT:
+        scan.x = db.x1;
+        scan.y = db.y1;
+        scan.colDx = 1;
+        scan.colDy = 0;
+        scan.rowDx = 0;
+        scan.rowDy = 1;
+        break;
+    case LANDSCAPE:
+        scan.x = db.y1;
+        scan.y = deviceWidth - 1 - db.x1;
+        scan.colDx = 0;
+        scan.colDy = -1;
+        scan.rowDx = 1;
+        scan.rowDy = 0;
+        break;
+    case PORTRAIT_FLIP:
+        scan.x = deviceWidth - 1 - db.x1;
+        scan.y = deviceHeight - 1 - db.y1;
+        scan.colDx = -1;
+        scan.colDy = 0;
+        scan.rowDx = 0;
+        scan.rowDy = -1;
+        break;
+    case LANDSCAPE_FLIP:
+        scan.x = deviceHeight - 1 - db.y1;
+        scan.y = db.x1;
+        scan.colDx = 0;
+        scan.colDy = 1;
+        scan.rowDx = -1;
+        scan.rowDy = 0;
+        break;
+    }
+    scan.cols = db.x2 - db.x1 + 1;
+    scan.rows = db.y2 - db.y1 + 1;
+
+    return true;
+}
+
 void PixelsBase::fill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
@@ -1880,7 +3246,8 @@ void PixelsBase::fill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
     } else {
         int s = currentScroll;
         if ( orientation > 1 ) {
-            s = (deviceHeight - s - 1) % deviceHeight;
+            // the same offset as drawPixel() and openWindow(): transformBounds() has already flipped y
+            s = (deviceHeight - s) % deviceHeight;
             bb.y1 += s;
             bb.y2 += s;
         } else {
@@ -1902,11 +3269,11 @@ void PixelsBase::fill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
 }
 
 void PixelsBase::hLine(int16_t x1, int16_t y, int16_t x2) {
-    fill(foreground->convertTo565(), x1, y, x2, y);
+    fill(foregroundColor, x1, y, x2, y);
 }
 
 void PixelsBase::vLine(int16_t x, int16_t y1, int16_t y2) {
-    fill(foreground->convertTo565(), x, y1, x, y2);
+    fill(foregroundColor, x, y1, x, y2);
 }
 
 void PixelsBase::resetRegion() {
@@ -1922,6 +3289,19 @@ void PixelsBase::setCurrentPixel(RGB* color) {
     deviceWriteData(highByte(c), lowByte(c));
 }
 
+void PixelsBase::deviceWritePixels(const uint16_t* data, uint32_t n) {
+    while ( n-- > 0 ) {
+        deviceWriteData(highByte(*data), lowByte(*data));
+        data++;
+    }
+}
+
+void PixelsBase::deviceWriteRepeat(uint16_t color, uint32_t n) {
+    while ( n-- > 0 ) {
+        deviceWriteData(highByte(color), lowByte(color));
+    }
+}
+
 boolean PixelsBase::transformBounds(Bounds& bb) {
 
     int16_t buf;
@@ -1963,6 +3343,33 @@ boolean PixelsBase::transformBounds(Bounds& bb) {
     return true;
 }
 
+void PixelsBase::untransformBounds(Bounds& bb) {
+
+    Bounds db = bb;
+    switch( orientation ) {
+    case PORTRAIT:
+        break;
+    case LANDSCAPE:
+        bb.x1 = db.y1;
+        bb.x2 = db.y2;
+        bb.y1 = deviceWidth - db.x2 - 1;
+        bb.y2 = deviceWidth - db.x1 - 1;
+        break;
+    case PORTRAIT_FLIP:
+        bb.x1 = deviceWidth - db.x2 - 1;
+        bb.x2 = deviceWidth - db.x1 - 1;
+        bb.y1 = deviceHeight - db.y2 - 1;
+        bb.y2 = deviceHeight - db.y1 - 1;
+        break;
+    case LANDSCAPE_FLIP:
+        bb.x1 = deviceHeight - db.y2 - 1;
+        bb.x2 = deviceHeight - db.y1 - 1;
+        bb.y1 = db.x1;
+        bb.y2 = db.x2;
+        break;
+    }
+}
+
 boolean PixelsBase::checkBounds(Bounds& bb) {
     if (bb.x2 < bb.x1) {
         swap(bb.x1, bb.x2);
@@ -31,6 +31,12 @@
 // #define DISABLE_ANTIALIASING 1
 // #define NO_FILL_TEXT_BACKGROUND 1
 // #define NO_TEXT_WRAP 1
+// #define NO_GLYPH_INDEX 1
+// one bit color output: no blending, no video memory reads and no color objects allocated. Pixels.cpp must
+// see the define as well, so set it here or globally (-DPIXELS_MONOCHROME); Pixels_Monochrome.h checks it
+// #define PIXELS_MONOCHROME 1
+// 9-bit hardware SPI: send pixel bursts byte by byte with a bit-banged D/C bit instead of packed to nine byte groups
+// #define NO_SPI_PACKING 1
 
 
 #define SPI_CLOCK_DIV4 0x00
@@ -98,6 +104,18 @@
     #define regtype volatile uint32_t
     #define regsize uint32_t
 
+#elif !defined(ARDUINO)
+    #include "Pixels_Host.h"
+
+    #define prog_uchar const unsigned char
+    #define prog_uint16_t const uint16_t
+
+    #define cbi(reg, bitmask) *reg &= ~bitmask
+    #define sbi(reg, bitmask) *reg |= bitmask
+
+    #define regtype volatile uint32_t
+    #define regsize uint32_t
+
 #else
     #define PROGMEM
 
@@ -116,6 +134,37 @@
 #define ANTIALIASED_FONT 2
 #define HEADER_LENGTH 5
 
+#ifndef PIXEL_BUFFER_SIZE
+#define PIXEL_BUFFER_SIZE 32 // number of points collected to be drawn as horizontal or vertical runs; 0 disables
+#endif
+#if PIXEL_BUFFER_SIZE > 255
+#error PIXEL_BUFFER_SIZE must not exceed 255: the point buffer is counted with 8bit variables
+#endif
+
+#ifndef PIXEL_CHUNK_SIZE
+#define PIXEL_CHUNK_SIZE 16 // number of bitmap pixels collected on stack to be sent with a single burst write
+#endif
+
+#ifndef BLEND_BUFFER_SIZE
+#define BLEND_BUFFER_SIZE 32 // number of pixels read back, blended and written at once; larger regions go in tiles
+#endif
+
+#ifndef FILE_CHUNK_SIZE
+#define FILE_CHUNK_SIZE 32 // number of image file pixels read at once; the file bytes and the converted pixels are buffered separately
+#endif
+
+#ifndef GLYPH_BUFFER_SIZE
+// max glyph box area (in pixels) to render through a single device window; 0 disables.
+// The coverage buffer of that many bytes is on stack, so it is kept small on AVR
+#if defined(__AVR__) && defined(RAMEND) && RAMEND < 0x1000
+#define GLYPH_BUFFER_SIZE 128
+#elif defined(__AVR__)
+#define GLYPH_BUFFER_SIZE 256
+#else
+#define GLYPH_BUFFER_SIZE 1024
+#endif
+#endif
+
 #define SCROLL_SMOOTH 1
 #define SCROLL_CLEAN 2
 
@@ -136,16 +185,82 @@
 #define FILL_TEXT_BACKGROUND 1
 
 
-#define ipart(X) ((int16_t)(X))
-#define iround(X) ((uint16_t)(((double)(X))+0.5))
-#define fpart(X) (((double)(X))-(double)ipart(X))
-#define rfpart(X) (1.0-fpart(X))
 
-extern regtype *registerCS; // chip select
-extern regsize bitmaskCS;
+/*
+ * Completion callback of an asynchronous transfer. On a microcontroller it runs in an interrupt handler,
+ * after the bus is released if no other transfer is queued: it may set flags or start the next transfer
+ * with drawRasterAsync(), it must not wait for transfers
+ */
+typedef void (*PixelsTransferDone)(void* context);
 
-#define chipSelect() cbi(registerCS, bitmaskCS)
-#define chipDeselect() sbi(registerCS, bitmaskCS)
+/*
+ * Chip select of a display instance. It is a virtual base of PixelsBase and of the bus classes, so
+ * a driver object has a single one. Displays sharing a bus are selected one at a time: selecting
+ * a display deselects the one that held the bus. A graphics operation of a display must complete
+ * before another display on the bus is drawn to.
+ *
+ * Every Pixels_<CONTROLLER>.h defines a class named after the controller (PixelsILI9341, PixelsSSD1306, ...).
+ * The first one included is also available as Pixels. A sketch driving several displays includes the bus,
+ * then all the drivers it needs and creates an object per display with its own chip select pin.
+ * The drivers pick their bus class at compile time from the bus headers included, in the order SPIsw,
+ * SPIhw, PPI8, PPI16, so all the displays of a sketch use the same bus type: a PPI TFT and a SPI OLED
+ * cannot be driven together.
+ *
+ * A bus with an asynchronous backend (see Pixels_Transfer.h) keeps the display selected while queued
+ * pixels are sent; the next selection of a display on the bus waits for the transfers to complete.
+ */
+class PixelsChipSelect {
+protected:
+    regtype *registerCS;
+    regsize bitmaskCS;
+
+    /* display holding the bus (NULL if none) */
+    static PixelsChipSelect* selectedChip;
+    /* set by the bus backend while it sends queued transfers (NULL if the bus sends synchronously only) */
+    volatile boolean* transferBusy;
+
+    PixelsChipSelect() {
+        registerCS = NULL;
+        bitmaskCS = 0;
+        transferBusy = NULL;
+    }
+
+    inline boolean isTransferring() {
+        return transferBusy != NULL && *transferBusy;
+    }
+
+    /* queues pixels to the current region of the bus backend; false if the bus sends synchronously only */
+    virtual boolean queuePixels(const uint16_t* data, uint32_t n, PixelsTransferDone done, void* context) {
+        return false;
+    }
+
+    inline void selectChip() {
+        while ( isTransferring() ) {
+        }
+        if ( selectedChip != this ) {
+            if ( selectedChip != NULL ) {
+                while ( selectedChip->isTransferring() ) {
+                }
+                selectedChip->deselectChip();
+            }
+            selectedChip = this;
+        }
+        cbi(registerCS, bitmaskCS);
+    }
+
+    inline void deselectChip() {
+        if ( isTransferring() ) {
+            return; // released by the next selection or waitTransfers()
+        }
+        sbi(registerCS, bitmaskCS);
+        if ( selectedChip == this ) {
+            selectedChip = NULL;
+        }
+    }
+};
+
+#define chipSelect() selectChip()
+#define chipDeselect() deselectChip()
 
 class RGB {
 private:
@@ -162,9 +277,29 @@ public:
 
     RGB convert565toRGB(uint16_t color);
     uint16_t convertRGBto565(RGB color);
-    uint16_t convertTo565();
+    inline uint16_t convertTo565() {
+        return col;
+    }
 };
 
+/*
+ * Packs 8bit color components to a RGB565 word, at compile time for constant arguments.
+ * See PixelsBase::setColor565()
+ */
+#if __cplusplus >= 201103L
+constexpr
+#else
+inline
+#endif
+uint16_t RGB565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint16_t)(r & 0xf8) << 8) | ((uint16_t)(g & 0xfc) << 3) | (b >> 3);
+}
+
+/*
+ * One bit color of a RGB565 value: lit if any of the components is above the half of its range
+ */
+#define LIT565(color) (((color) & 0x8410) != 0)
+
 class Bounds {
 public:
     int16_t x1;
@@ -180,7 +315,112 @@ public:
     }
 };
 
-class PixelsBase {
+/*
+ * Describes an order the pixels of a device window are written in: starting at logical
+ * point (x, y), each next pixel of a device row is at (x + colDx, y + colDy) and each next
+ * device row starts at (x + rowDx, y + rowDy)
+ */
+class WindowScan {
+public:
+    int16_t x;
+    int16_t y;
+    int8_t colDx;
+    int8_t colDy;
+    int8_t rowDx;
+    int8_t rowDy;
+    int16_t cols;
+    int16_t rows;
+};
+
+/*
+ * A text line laid out by PixelsBase::measureText(): characters from start up to end (exclusive),
+ * width pixels wide. Spaces and line feeds a line is broken at belong to no line
+ */
+class TextLine {
+public:
+    uint16_t start;
+    uint16_t end;
+    int16_t width;
+};
+
+/*
+ * Read-only view of a text in RAM or in program memory, the text methods of PixelsBase take.
+ * A view is made implicitly from a char array, a String or a F() string, so the text is neither
+ * copied nor allocated. A PSTR() string is passed as (const __FlashStringHelper*)PSTR("...")
+ */
+class PixelsText {
+private:
+    const char* data;
+    uint16_t len;
+    boolean flash;
+
+public:
+    PixelsText() {
+        data = "";
+        len = 0;
+        flash = false;
+    }
+
+    PixelsText(const char* text) {
+        data = text == NULL ? "" : text;
+        len = strlen(data);
+        flash = false;
+    }
+
+    PixelsText(const __FlashStringHelper* text) {
+        data = (const char*)text;
+        len = strlen_P(data);
+        flash = true;
+    }
+
+    PixelsText(const String& text) {
+        data = text.c_str();
+        len = text.length();
+        flash = false;
+    }
+
+    inline uint16_t length() const {
+        return len;
+    }
+
+    inline char charAt(uint16_t i) const {
+        return flash ? pgm_read_byte_near(data + i) : data[i];
+    }
+
+    /* view of the characters from position from up to (exclusive) to */
+    PixelsText substring(uint16_t from, uint16_t to) const {
+        PixelsText part = *this;
+        if ( to > len ) {
+            to = len;
+        }
+        if ( from > to ) {
+            from = to;
+        }
+        part.data = data + from;
+        part.len = to - from;
+        return part;
+    }
+};
+
+/*
+ * Sequential access to image files for PixelsBase::loadBitmap(). See Pixels_Files.h for SD card
+ * and POSIX implementations
+ */
+class PixelsFileSource {
+public:
+    virtual ~PixelsFileSource() {}
+    /* opens the file for reading, returns false if it cannot be opened */
+    virtual boolean open(const char* path) = 0;
+    /* reads up to length bytes, returns the number of bytes read (0 at the end of the file) */
+    virtual int32_t read(uint8_t* buffer, int32_t length) = 0;
+    /* moves to the given offset from the file start */
+    virtual boolean seek(uint32_t position) = 0;
+    virtual void close() = 0;
+};
+
+class PixelsCanvas;
+
+class PixelsBase : public virtual PixelsChipSelect {
 protected:
     /* device physical dimension in portrait orientation */
     int16_t deviceWidth;
@@ -194,14 +434,32 @@ protected:
 
     uint8_t orientation;
 
+    /* the controller scan direction follows the orientation (if the controller supports that) */
+    boolean hardwareOrientation;
+
+    /* the video memory can be read back: -1 until canReadRegion() is first asked */
+    int8_t readBack;
+
     boolean relativeOrigin;
 
     /* currently selected font */
     prog_uchar* currentFont;
 
+#ifndef NO_GLYPH_INDEX
+    /* glyph offsets of the current font indexed by a character code (0 - no glyph) */
+    uint16_t* glyphIndex;
+    uint16_t glyphIndexCapacity;
+    uint16_t glyphIndexLength;
+    uint8_t glyphIndexFirst;
+#endif
+
     RGB* foreground;
     RGB* background;
 
+    /* foreground and background packed to RGB565 by setColor() and setBackground() */
+    uint16_t foregroundColor;
+    uint16_t backgroundColor;
+
     double lineWidth;
 
     uint8_t fillDirection;
@@ -215,6 +473,25 @@ protected:
     boolean scrollCleanMode;
     uint16_t extraScrollDelay;
 
+    /* scroll started with startScroll() and advanced by tick() */
+    boolean scrolling;
+    int8_t scrollFlags;
+    int16_t scrollDistance;
+    int16_t scrollDone;
+    uint16_t scrollDuration;
+    unsigned long scrollStart;
+
+    /* marquee started with startMarquee() and advanced by tick() */
+    boolean marqueeRunning;
+    PixelsText marqueeText;
+    int16_t marqueeY;
+    uint8_t marqueeStep;
+    uint8_t marqueeRepeat; // loops left, 0 - infinite
+    uint16_t marqueeInterval;
+    uint16_t marqueeChar; // glyph cursor: the character entering the screen
+    int16_t marqueeColumn; // next glyph column to enter, or blank columns passed after the text
+    unsigned long marqueeLast;
+
     int16_t caretX;
     int16_t caretY;
 
@@ -227,38 +504,125 @@ protected:
     int16_t textWrapLineGap;
 
     boolean textWrapScroll;
+    boolean textWrapScrollSmooth;
     int16_t textWrapMarginBottom;
     RGB* textWrapScrollFill;
 #endif
 
     int gfxOpNestingDepth;
 
+#if PIXEL_BUFFER_SIZE > 0
+    /* points (x, y pairs) to be drawn with the current color by flushPixels() */
+    int16_t pointBuffer[2 * PIXEL_BUFFER_SIZE];
+    uint8_t pointBufferLength;
+#endif
+
     boolean transformBounds(Bounds& bb);
+    /* maps device bounds back to the logical coordinate space of the current orientation */
+    void untransformBounds(Bounds& bb);
     boolean checkBounds(Bounds& bb);
-    void printString(int16_t xx, int16_t yy, String text, boolean clean, int8_t kerning[] = NULL);
+    void printString(int16_t xx, int16_t yy, const PixelsText& text, boolean clean, int8_t kerning[] = NULL);
     void drawGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t yy,
                                int16_t height, prog_uchar* data, int16_t length);
+    boolean blitGlyph(int16_t fontType, boolean clean, int16_t xx, int16_t yy,
+                               int16_t height, prog_uchar* data, int16_t length);
+    /* draws columns column .. column + columns - 1 of a glyph box with its background, the first one at x */
+    void drawGlyphColumns(int16_t fontType, int16_t x, int16_t yy, int16_t glyphHeight,
+                               prog_uchar* data, int16_t length, int16_t column, int16_t columns);
+    /* advances the scroll movement started with startScroll() */
+    boolean advanceScroll(unsigned long nowMs);
+    /* starts the marquee for startMarquee(), which takes only the texts that may outlive the call */
+    void beginMarquee(int16_t y, const PixelsText& text, uint8_t scrollStep, uint16_t stepMs, uint8_t repeat);
+    /* scrolls the marquee a step and draws the entering columns */
+    void stepMarquee();
+    /* writes a decoded bitmap line of the given width with its left end at (x, y) */
+    void writeRasterLine(int16_t x, int16_t y, const uint16_t* raster, int16_t width);
+    /* clips the (sx, sy, sw, sh) part of a width x height image drawn at (x, y) to the image and the
+       visible area; rb receives the visible part, stream is set if a window for it has been opened */
+    boolean openRasterRegion(int16_t x, int16_t y, int16_t width, int16_t height,
+                               int16_t sx, int16_t sy, int16_t sw, int16_t sh, Bounds& rb, boolean& stream);
+    /* writes a decoded row of a region opened with openRasterRegion() */
+    inline void writeRasterRow(boolean stream, int16_t x, int16_t y, const uint16_t* raster, int16_t width) {
+        if ( stream ) {
+            deviceWritePixels(raster, width);
+        } else {
+            writeRasterLine(x, y, raster, width);
+        }
+    }
+    /* decodes the byte aligned 'R' bitmap format (see Pixels.cpp) */
+    int8_t drawRunLengthBitmap(int16_t x, int16_t y, prog_uchar* data,
+                               int16_t sx, int16_t sy, int16_t sw, int16_t sh);
+#ifndef PIXELS_MONOCHROME
+    /* blends the glyph coverage of the (x1, y) - (x2, y) ink span with the video memory under it */
+    void blendGlyphSpan(int16_t x1, int16_t y, int16_t x2, uint8_t* coverage, int16_t offsetLeft, int16_t offsetTop,
+                        int16_t eff, boolean vraster);
+#endif
+    void blitCoverage(Bounds bb, uint8_t* coverage, int16_t offsetLeft, int16_t offsetTop,
+                               int16_t eff, int16_t lines, boolean vraster, boolean clean);
 
 #ifndef NO_TEXT_WRAP
-    int16_t computeBreakPos(String text, int16_t t);
+    /* lays out the wrapped line starting at text[start] and x and returns the next line start;
+       the kerning state moves to the line end */
+    uint16_t layoutLine(const PixelsText& text, uint16_t start, int16_t x, int8_t kerning[],
+                               int16_t& kernPtr, int16_t& kern, TextLine& line);
+#endif
+
+#ifndef NO_GLYPH_INDEX
+    void buildGlyphIndex();
 #endif
+    prog_uchar* findGlyph(char c);
 
     virtual int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) { return -1; }
+    /* sets a device region the controller scans in the logical row order of the current orientation;
+       returns false if the controller cannot do that */
+    virtual boolean setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) { return false; }
+    inline boolean orientRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+        return hardwareOrientation && orientation != PORTRAIT && setOrientedRegion(x1, y1, x2, y2);
+    }
+    boolean openWindow(Bounds bb, uint8_t part, WindowScan& scan, boolean read = false);
+
+    /* video memory read: beginReadRegion() returns false if the controller or the bus does not support it */
+    virtual boolean canReadRegion() { return false; }
+    inline boolean canReadBack() {
+        if ( readBack < 0 ) {
+            readBack = canReadRegion();
+        }
+        return readBack != 0;
+    }
+    virtual boolean beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) { return false; }
+    virtual uint16_t deviceReadData() { return 0; }
+    virtual void endReadRegion() {}
+    void blendRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t* alpha);
+    /* blends a region of at most BLEND_BUFFER_SIZE pixels; its alpha rows are stride values apart */
+    void blendTile(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t* alpha, int16_t stride);
 
     void setCurrentPixel(RGB* color);
     void setCurrentPixel(int16_t color);
+    /* draws a pixel at device coordinates in a gfx operation of its own; PixelsStatic binds the steps statically */
+    virtual void devicePixel(int16_t x, int16_t y, uint16_t color) {
+        beginGfxOperation();
+        setRegion(x, y, x, y);
+        deviceWriteData(highByte(color), lowByte(color));
+        endGfxOperation();
+    }
+    void bufferPixel(int16_t x, int16_t y);
+    void flushPixels();
     void fill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     virtual void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {}
-    void putColor(int16_t x, int16_t y, boolean steep, double weight);
-    RGB* computeColor(RGB* bg, double weight);
+    void putColor(int16_t x, int16_t y, boolean steep, uint8_t alpha);
+    RGB* blendColor(RGB* bg, uint8_t alpha);
     RGB* computeColor(RGB* fg, uint8_t opacity);
 
     void resetRegion();
 
+    void drawLineRun(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void hLine(int16_t x1, int16_t y1, int16_t x2);
     void vLine(int16_t x1, int16_t y1, int16_t y2);
 
     virtual void deviceWriteData(uint8_t hi, uint8_t lo) {}
+    /* burst writes of n pixels to the current region; drivers map them to bus specific loops */
+    virtual void deviceWritePixels(const uint16_t* data, uint32_t n);
+    virtual void deviceWriteRepeat(uint16_t color, uint32_t n);
 
     virtual void scrollCmd() {}
 
@@ -267,12 +631,34 @@ protected:
     virtual void drawLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     virtual void drawRoundRectangleAntialiased(int16_t x, int16_t y, int16_t width, int16_t height, int16_t rx, int16_t ry, boolean bordermode);
 
-    int16_t* loadFileBytes(String);
+    /* image files source of loadBitmap() */
+    PixelsFileSource* fileSource;
+    /* draws the file opened by the file source (see loadBitmap()) */
+    int8_t streamBitmap(int16_t x, int16_t y, int16_t width, int16_t height);
 
+#ifdef PIXELS_MONOCHROME
+    /* the off and on colors all the color setters pick from; nothing is blended or allocated */
+    static RGB monoColors[2];
+#else
     RGB* computedBgColor;
     RGB* computedFgColor;
+#endif
+
+    /* 8bit color components of a RGB565 value; the upper bits repeat in the low ones, so white stays white */
+    static inline uint8_t expand565Red(uint16_t color) {
+        return ((color >> 8) & 0xf8) | (color >> 13);
+    }
+    static inline uint8_t expand565Green(uint16_t color) {
+        return ((color >> 3) & 0xfc) | ((color >> 9) & 0x03);
+    }
+    static inline uint8_t expand565Blue(uint16_t color) {
+        return ((color << 3) & 0xf8) | ((color >> 2) & 0x07);
+    }
+#ifndef PIXELS_MONOCHROME
     RGB* bgBuffer;
     RGB* fgBuffer;
+    RGB* pixelBuffer;
+#endif
 
     virtual void beginGfxOperation() {
         chipSelect();
@@ -299,6 +685,10 @@ public:
      * @param height target device height (in pixels)
      */
     PixelsBase(uint16_t width, uint16_t height);
+    /**
+     * Releases the color buffers and the glyph index.
+     */
+    virtual ~PixelsBase();
     /**
      * Initializes hardware with defaults.
      */
@@ -317,6 +707,17 @@ public:
     inline uint8_t getOrientation() {
         return orientation;
     }
+    /**
+     * Enables or disables the controller driven orientation. If enabled, bitmaps, glyphs and canvases
+     * are streamed in their source order in every orientation: the controller scan direction is
+     * switched to the orientation instead of remapping the pixels in software.
+     * Takes no effect if the controller does not support scan direction control.
+     * @param enable a boolean value that determines whether the controller driven orientation should be enabled or not
+     * @see setOrientation(uint8_t)
+     */
+    inline void enableHardwareOrientation(boolean enable) {
+        hardwareOrientation = enable;
+    }
     /**
      * Enables or disables antialiasing by a drawing of graphical primitives. The metod does not impact antialiased fonts.
      * Antialiased output in general requires more resources/time to output comparing to "grainy" output mode.
@@ -417,8 +818,12 @@ public:
      * @param b the blue component
      */
     inline void setBackground(uint8_t r, uint8_t g, uint8_t b) {
+#ifdef PIXELS_MONOCHROME
+        setBackground(&monoColors[((r | g | b) & 0x80) != 0]);
+#else
         bgBuffer->setColor(r, g, b);
         setBackground(bgBuffer);
+#endif
     }
     /**
      * Sets the current color to the specified color.
@@ -428,24 +833,71 @@ public:
      * @param b the blue component
      */
     inline void setColor(uint8_t r, uint8_t g, uint8_t b) {
+#ifdef PIXELS_MONOCHROME
+        setColor(&monoColors[((r | g | b) & 0x80) != 0]);
+#else
         fgBuffer->setColor(r, g, b);
         setColor(fgBuffer);
+#endif
     }
     /**
      * Sets the current background color to the specified color.
      * All subsequent relevant graphics operations use this specified color.
+     * A later change of the color object takes effect with the next setBackground() call.
      * @param color color object reference
      */
     inline void setBackground(RGB* color) {
         background = color;
+        backgroundColor = color->convertTo565();
     }
     /**
      * Sets the current color to the specified color.
      * All subsequent graphics operations use this specified color.
+     * A later change of the color object takes effect with the next setColor() call.
      * @param color color object
      */
     inline void setColor(RGB* color) {
         foreground = color;
+        foregroundColor = color->convertTo565();
+    }
+    /**
+     * Sets the current background color to a RGB565 value, e.g. one packed with RGB565(r,g,b)
+     * @param color RGB565 color
+     */
+    inline void setBackground565(uint16_t color) {
+#ifdef PIXELS_MONOCHROME
+        setBackground(&monoColors[LIT565(color)]);
+#else
+        bgBuffer->setColor(expand565Red(color), expand565Green(color), expand565Blue(color));
+        background = bgBuffer;
+        backgroundColor = color;
+#endif
+    }
+    /**
+     * Sets the current color to a RGB565 value, e.g. one packed at compile time with RGB565(r,g,b).
+     * Drawing does not convert the color any more.
+     * @param color RGB565 color
+     */
+    inline void setColor565(uint16_t color) {
+#ifdef PIXELS_MONOCHROME
+        setColor(&monoColors[LIT565(color)]);
+#else
+        fgBuffer->setColor(expand565Red(color), expand565Green(color), expand565Blue(color));
+        foreground = fgBuffer;
+        foregroundColor = color;
+#endif
+    }
+    /**
+     * @return the current color as RGB565 value
+     */
+    inline uint16_t getColor565() {
+        return foregroundColor;
+    }
+    /**
+     * @return the current background color as RGB565 value
+     */
+    inline uint16_t getBackground565() {
+        return backgroundColor;
     }
     /**
      * Gets the graphics context's current background color.
@@ -471,6 +923,19 @@ public:
      * @return  pixel color or the graphics context's current background color.
      */
     RGB* getPixel(int16_t x, int16_t y);
+
+    /**
+     * Reads a rectangular area of video memory as RGB565 values, row by row.
+     * Requires video RAM read support by the controller and by the bus (PPI with RD pin assigned).
+     * Values for pixels out of the visible area are left unchanged.
+     * @param x1 left <i>x</i> coordinate
+     * @param y1 top <i>y</i> coordinate
+     * @param x2 right <i>x</i> coordinate
+     * @param y2 bottom <i>y</i> coordinate
+     * @param out buffer for (x2 - x1 + 1) * (y2 - y1 + 1) values
+     * @return true if video RAM read is supported
+     */
+    boolean readRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t* out);
     /**
      * Draws a pixel, using the current color, at the point
      * <code>(x,&nbsp;y)</code>
@@ -479,6 +944,14 @@ public:
      * @param   y  <i>y</i> coordinate.
      */
     void drawPixel(int16_t x, int16_t y);
+
+    /**
+     * Draws a set of points with the current color. Points are sorted and neighbouring ones are
+     * joined to horizontal or vertical runs, so each run needs a single video memory window.
+     * @param xy    <i>x</i>, <i>y</i> coordinate pairs
+     * @param n     number of points
+     */
+    void drawPixels(const int16_t* xy, uint16_t n);
     /**
      * Draws a line, using the current color, between the points
      * <code>(x1,&nbsp;y1)</code> and <code>(x2,&nbsp;y2)</code>
@@ -616,18 +1089,72 @@ public:
      * @see      loadBitmap(int16_t,int16_t,int16_t,int16_t,String)
      */
     int8_t drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, prog_uint16_t* data);
+    /**
+     * Draws RGB565 pixels from RAM, e.g. a strip rendered into a PixelsCanvas, without waiting for
+     * the transfer if the bus has an asynchronous backend (see Pixels_Transfer.h). The CPU can render the
+     * next strip meanwhile; the buffer must stay unchanged until <code>done</code> is called.
+     * A clipped image or an orientation the controller does not scan in logical order is drawn
+     * synchronously, as it is with a synchronous bus; <code>done</code> is called before the return then.
+     * @param    x   the <i>x</i> coordinate.
+     * @param    y   the <i>y</i> coordinate.
+     * @param    width   the width of the image.
+     * @param    height   the height of the image.
+     * @param    data   the pixels row by row.
+     * @param    done   called once the buffer is sent (may be NULL). On a microcontroller it runs in an interrupt
+     *               handler; see PixelsTransferDone for what it may do.
+     * @param    context   passed to <code>done</code>.
+     * @return   0 on success and 1 if the image is out of screen.
+     * @see      waitTransfers()
+     */
+    int8_t drawRasterAsync(int16_t x, int16_t y, int16_t width, int16_t height, const uint16_t* data,
+                           PixelsTransferDone done = NULL, void* context = NULL);
+    /**
+     * Waits for the asynchronous transfers to complete and releases the display.
+     * @see      drawRasterAsync(int16_t,int16_t,int16_t,int16_t,const uint16_t*,PixelsTransferDone,void*)
+     */
+    void waitTransfers();
+    /**
+     * Draws content of an off-screen canvas through a single device window.
+     * The canvas is drawn with its top-left corner at
+     * (<i>x</i>,&nbsp;<i>y</i>) in the current coordinate
+     * space. Requires Pixels_Canvas.h to be included.
+     * @param    x   the <i>x</i> coordinate.
+     * @param    y   the <i>y</i> coordinate.
+     * @param    canvas   the canvas to draw.
+     * @see      PixelsCanvas
+     */
+    void blitCanvas(int16_t x, int16_t y, PixelsCanvas* canvas);
     /**
      * Draws specified bitmap image.
      * The image is drawn with its top-left corner at
      * (<i>x</i>,&nbsp;<i>y</i>) in the current coordinate
      * space.
-     * @param    data compressed (with Pixelmeister) bitmap image bytes. This method does
+     * @param    data compressed (with Pixelmeister, 'Z' format) or run length encoded (with
+     *               extras/encoder, 'R' format) bitmap image bytes. This method does
      *               nothing if <code>img</code> is null.
      * @param    x   the <i>x</i> coordinate.
      * @param    y   the <i>y</i> coordinate.
      * @see      drawBitmap(int16_t,int16_t,int16_t,int16_t,int[])
      */
     int8_t drawCompressedBitmap(int16_t x, int16_t y, prog_uchar* data);
+    /**
+     * Draws a part of specified bitmap image, e.g. to restore a background behind a moving widget.
+     * The part is drawn with its top-left corner at
+     * (<i>x</i>,&nbsp;<i>y</i>) in the current coordinate
+     * space. Only the visible rows of the part are decoded: 'R' format images encoded with
+     * checkpoints (extras/encoder -i option) are decoded from the checkpoint closest to the part,
+     * other images from the top.
+     * @param    x   the <i>x</i> coordinate.
+     * @param    y   the <i>y</i> coordinate.
+     * @param    data compressed bitmap image bytes (see drawCompressedBitmap()).
+     * @param    sx  the left edge of the part in the image.
+     * @param    sy  the top edge of the part in the image.
+     * @param    sw  the part width.
+     * @param    sh  the part height.
+     * @see      drawCompressedBitmap(int16_t,int16_t,prog_uchar*)
+     */
+    int8_t drawCompressedBitmapRegion(int16_t x, int16_t y, prog_uchar* data,
+                                      int16_t sx, int16_t sy, int16_t sw, int16_t sh);
     /**
      * Draws an icon, prepared with Pixelmeister.
      * The icon is drawn with its top-left corner at
@@ -664,16 +1191,29 @@ public:
     int16_t getIconWidth(prog_uchar* data) {
         return pgm_read_byte_near(data + 5);
     }
+    /**
+     * Sets a source of image files for loadBitmap().
+     * @param    source file source, e.g. PixelsSDFile or PixelsPosixFile of Pixels_Files.h.
+     * @see      loadBitmap(int16_t,int16_t,int16_t,int16_t,String)
+     */
+    inline void setFileSource(PixelsFileSource* source) {
+        fileSource = source;
+    }
     /**
      * Loads from an external FAT-drive and draws specified bitmap image.
      * The image is drawn with its top-left corner at
      * (<i>x</i>,&nbsp;<i>y</i>) in the current coordinate
-     * space.
+     * space. The file is streamed to the display in small chunks, the image is never loaded
+     * completely. BMP files (16bit 565 or 555 and 24bit color) are recognized by their header,
+     * any other file is read as raw 565 pixels, high byte first.
      * @param    path to the image.
      * @param    x   the <i>x</i> coordinate.
      * @param    y   the <i>y</i> coordinate.
-     * @param    width   the width of the image.
-     * @param    height   the height of the image.
+     * @param    width   the width of a raw image. Limits the drawn width of a BMP image if positive.
+     * @param    height   the height of a raw image. Limits the drawn height of a BMP image if positive.
+     * @return   0 on success, 1 if the image is out of screen, -1 if the file cannot be opened
+     *           (or no file source is set), -2 for an unsupported format and -3 for a read error.
+     * @see      setFileSource(PixelsFileSource*)
      * @see      drawBitmap(int16_t,int16_t,int16_t,int16_t,int[])
      */
     int8_t loadBitmap(int16_t x, int16_t y, int16_t width, int16_t height, String path);
@@ -686,9 +1226,11 @@ public:
      * supports scrolling). Scroll axis is vertical by portrait orientation and horizontal
      * by landscape orientation (hardware scpecifics).
      * SCROLL_CLEAN flag forces to paint wrapped regions with background color. SCROLL_SMOOTH
-     * eases begin and end of a scroll movement (by big dy values).
+     * eases begin and end of a scroll movement (by big dy values). A smooth scroll returns when
+     * the movement is complete; see startScroll() for a scroll that does not block.
      * @param dy negative or positive scroll distance
      * @param flags can be 0, SCROLL_SMOOTH or/and SCROLL_CLEAN
+     * @see startScroll(int16_t,int8_t,uint16_t)
      */
     void scroll(int16_t dy, int8_t flags);
 
@@ -708,6 +1250,41 @@ public:
         extraScrollDelay = ms;
     }
 
+    /**
+     * Starts a scroll movement the caller advances with tick(), so the program stays responsive
+     * while the display scrolls. The movement takes a given time regardless of the distance:
+     * each tick() scrolls as many lines as the elapsed time allows. A scroll in progress is
+     * completed first.
+     * @param dy negative or positive scroll distance
+     * @param flags can be 0, SCROLL_SMOOTH (eases begin and end of the movement, otherwise the
+     *        speed is constant) or/and SCROLL_CLEAN
+     * @param durationMs duration of the movement in milliseconds
+     * @see tick(unsigned long)
+     * @see scroll(int16_t,int8_t)
+     */
+    void startScroll(int16_t dy, int8_t flags, uint16_t durationMs);
+
+    /**
+     * Advances a scroll movement started with startScroll() and a marquee started with
+     * startMarquee() to a given time.
+     * @param nowMs current time, normally millis()
+     * @return <i>true</i> if the scroll movement or the marquee is not complete yet
+     * @see startMarquee(int16_t,const char*,uint8_t,uint16_t,uint8_t)
+     */
+    boolean tick(unsigned long nowMs);
+
+    /**
+     * @return <i>true</i> if a scroll movement started with startScroll() is not complete yet
+     */
+    inline boolean isScrolling() {
+        return scrolling;
+    }
+
+    /**
+     * Completes a scroll movement started with startScroll() at once.
+     */
+    void finishScroll();
+
     /**
      * returns current print mode
      * @see setPrintMode(int8_t)
@@ -757,12 +1334,14 @@ public:
      * Takes no effect if text wrap is not enabled or by landscape page orientation.
      * @param  marginBottom bottom screen space, to avoid to print to
      * @param  scrollFill background color to pre-fill blank area
+     * @param  smooth the text scrolls smoothly (printing waits for the movement) or at once
      * @see    enableTextWrap(marginLeft,marginRight,int16_t)
      */
-    void enableTextWrapScroll(int16_t marginBottom, RGB* scrollFill = NULL) {
+    void enableTextWrapScroll(int16_t marginBottom, RGB* scrollFill = NULL, boolean smooth = true) {
 #ifndef NO_TEXT_WRAP
         textWrapMarginBottom = marginBottom;
         textWrapScrollFill = scrollFill;
+        textWrapScrollSmooth = smooth;
         textWrapScroll = true;
 #endif
     }
@@ -779,7 +1358,7 @@ public:
 
     /**
      * @return horizontal caret position after a text string is printed.
-     * @see print(int16_t,int16_t,String,int8_t)
+     * @see print(int16_t,int16_t,PixelsText,int8_t)
      * @see enableTextWrap(marginLeft,marginRight,int16_t)
      * @see enableTextWrapScroll(int16_t,RGB*)
      */
@@ -789,7 +1368,7 @@ public:
 
     /**
      * @return vertical caret position after a text string is printed.
-     * @see print(int16_t,int16_t,String,int8_t)
+     * @see print(int16_t,int16_t,PixelsText,int8_t)
      * @see enableTextWrap(marginLeft,marginRight,int16_t)
      * @see enableTextWrapScroll(int16_t,RGB*)
      */
@@ -818,11 +1397,11 @@ public:
      * @see         setFont(prog_uchar font[])
      * @see         setOriginRelative()
      * @see         setOriginAbsolute()
-     * @see         cleanText(int16_t,int16_t,String,int8_t[])
+     * @see         cleanText(int16_t,int16_t,PixelsText,int8_t[])
      */
-    void print(int16_t xx, int16_t yy, String text, int8_t kerning[] = NULL);
+    void print(int16_t xx, int16_t yy, const PixelsText& text, int8_t kerning[] = NULL);
     /**
-     * The method oposes print(int16_t,int16_t,String,int8_t[]) Erases the text given by
+     * The method oposes print(int16_t,int16_t,PixelsText,int8_t[]) Erases the text given by
      * the specified string by filling glyph shapes with the current background color.
      * The baseline of the leftmost character is at position (<i>x</i>,&nbsp;<i>y</i>)
      * in the current coordinate system.
@@ -836,9 +1415,9 @@ public:
      * @see         setFont(prog_uchar font[])
      * @see         setOriginRelative()
      * @see         setOriginAbsolute()
-     * @see         print(int16_t,int16_t,String,int8_t[])
+     * @see         print(int16_t,int16_t,PixelsText,int8_t[])
      */
-    void cleanText(int16_t xx, int16_t yy, String text, int8_t kerning[] = NULL);
+    void cleanText(int16_t xx, int16_t yy, const PixelsText& text, int8_t kerning[] = NULL);
     /**
      * Gets the current font text line height
      * @return text line height in pixels
@@ -850,16 +1429,31 @@ public:
      */
     int16_t getTextBaseline();
     /**
-     * Computes needed horizontal space to print the given text with print(int16_t,int16_t,String,int8_t)
+     * Computes needed horizontal space to print the given text with print(int16_t,int16_t,PixelsText,int8_t)
      * @param       text      the text string.
      * @param       kerning   optional array of integer kerning values in a range from
      * -99 to 99 to be applied to the string glyphs correspondingly. "-100" value ends
      * the kerning data. If the string has more characters than the array length, a value
      * precedes "-100" is used as a kerning hint for the rest of the string glyphs.
-     * @see         print(int16_t,int16_t,String,int8_t[])
+     * @see         print(int16_t,int16_t,PixelsText,int8_t[])
      * @return text baseline offset
      */
-    int16_t getTextWidth(String text, int8_t kerning[] = NULL);
+    int16_t getTextWidth(const PixelsText& text, int8_t kerning[] = NULL);
+
+    /**
+     * Lays out a text the way print(int16_t,int16_t,PixelsText,int8_t[]) does and stores the line table,
+     * so multi-line text can be aligned without measuring it again. If text wrap is disabled,
+     * the text takes one line.
+     * @param       x         horizontal coordinate the first line starts at. The following lines
+     * start at the wrap left margin
+     * @param       text      the text string.
+     * @param       lines     array to receive the text lines
+     * @param       maxLines  the array capacity. Lines past it are counted, but not stored
+     * @param       kerning   optional array of integer kerning values, see getTextWidth(PixelsText,int8_t[])
+     * @return number of text lines
+     * @see         enableTextWrap(int16_t,int16_t,int16_t)
+     */
+    int16_t measureText(int16_t x, const PixelsText& text, TextLine lines[], int16_t maxLines, int8_t kerning[] = NULL);
 
     /**
      * Returns width for a given character of the current font
@@ -881,79 +1475,156 @@ public:
      *
      * @see setScrollStepDelay(uint16_t)
      */
-    void scrollText( int16_t x, int16_t y, String text, uint8_t scrollStep, uint8_t repeat, uint16_t maxScroll );
+    void scrollText( int16_t x, int16_t y, const PixelsText& text, uint8_t scrollStep, uint8_t repeat, uint16_t maxScroll );
+
+    /**
+     * Starts a marquee: the text enters the screen from the right and scrolls out to the left,
+     * a step per tick() call once the step interval has passed. Every step scrolls the screen with
+     * hardware scrolling and draws only the entering columns of the text line (with the background
+     * color), so a step costs the same regardless of the text length. Screen content outside of the
+     * text line moves with it. Like scrollText(), the method switches PORTRAIT and PORTRAIT_FLIP
+     * orientations to LANDSCAPE. A running scroll movement is completed first.
+     * @param y vertical text coordinate
+     * @param text text to display, a char array or a F() string. The text is not copied: it has to stay
+     *        unchanged while the marquee runs. A String is not taken, as a temporary or local one would be
+     *        gone before the marquee ends; pass its c_str() only if the String outlives the marquee
+     * @param scrollStep scrolling step in pixels
+     * @param stepMs step interval in milliseconds
+     * @param repeat number of scroll loops. 0 repeats the text until stopMarquee() is called
+     * @see tick(unsigned long)
+     * @see scrollText(int16_t,int16_t,PixelsText,uint8_t,uint8_t,uint16_t)
+     */
+    void startMarquee(int16_t y, const char* text, uint8_t scrollStep = 1, uint16_t stepMs = 20, uint8_t repeat = 0) {
+        beginMarquee(y, PixelsText(text), scrollStep, stepMs, repeat);
+    }
+
+    /**
+     * Starts a marquee with a text in program memory.
+     * @see startMarquee(int16_t,const char*,uint8_t,uint16_t,uint8_t)
+     */
+    void startMarquee(int16_t y, const __FlashStringHelper* text, uint8_t scrollStep = 1, uint16_t stepMs = 20, uint8_t repeat = 0) {
+        beginMarquee(y, PixelsText(text), scrollStep, stepMs, repeat);
+    }
+
+    /**
+     * Stops a marquee started with startMarquee(). The text stays where it is.
+     */
+    void stopMarquee() {
+        marqueeRunning = false;
+    }
+
+    /**
+     * @return <i>true</i> if a marquee started with startMarquee() is running
+     */
+    inline boolean isMarqueeRunning() {
+        return marqueeRunning;
+    }
 };
 
+/*
+ * Static composition of a driver class, the Pixels typedef of the driver headers. The per pixel steps
+ * the library core reaches through virtual calls are bound to the driver's own methods here, so a pixel
+ * costs one virtual call and the driver code inlines down to the bus writes. A sketch that overrides the
+ * gfx operation, region or data methods should derive from the driver class instead
+ */
+template<class Driver> class PixelsStatic : public Driver {
+protected:
+    void devicePixel(int16_t x, int16_t y, uint16_t color) {
+        Driver::beginGfxOperation();
+        Driver::setRegion(x, y, x, y);
+        Driver::deviceWriteData(highByte(color), lowByte(color));
+        Driver::endGfxOperation(false);
+    }
+
+public:
+    PixelsStatic() : Driver() {
+    }
+
+    PixelsStatic(uint16_t width, uint16_t height) : Driver(width, height) {
+    }
+};
+
+/*
+ * Big endian bit stream reader. The next bits are kept left aligned in a 32bit accumulator
+ * refilled a byte at a time, so most reads do not touch the data. Bits past the end read as 0
+ */
 class BitStream {
 private:
     prog_uchar* data;
     size_t size;
-    int32_t bitpos;
+    size_t pos; // next byte to move to the accumulator
+    uint32_t bits; // the next bits, most significant first
+    uint8_t count; // number of the bits
+
+    void refill() {
+        while ( count <= 24 ) {
+            uint32_t b = pos < size ? pgm_read_byte_near(data + pos) : 0;
+            bits |= b << (24 - count);
+            count += 8;
+            pos++;
+        }
+    }
+
+    void skip(uint8_t len) {
+        bits <<= len;
+        count -= len;
+    }
 
 public:
     BitStream (prog_uchar* src_buffer, size_t byte_size, int8_t offset = 0) {
-        bitpos = offset;
         data = src_buffer;
         size = byte_size + (offset>>3);
+        pos = offset >> 3;
+        bits = 0;
+        count = 0;
+        refill();
+        skip(offset & 7);
     }
 
     bool endOfData() {
-        return (size_t)((bitpos + 1) >> 3) >= size;
+        return (size_t)((pos * 8 - count + 1) >> 3) >= size;
     }
 
     uint8_t testCurrentByte() {
-        uint8_t res = (uint8_t)pgm_read_byte_near(data + (bitpos>>3));
+        uint8_t res = (uint8_t)pgm_read_byte_near(data + ((pos * 8 - count) >> 3));
         return res;
     }
 
     uint8_t readBit() {
-        uint8_t res = (uint8_t)(pgm_read_byte_near(data + (bitpos>>3)) & (uint8_t)( (uint16_t)0x80 >> (bitpos & 7) ));
-        bitpos++;
+        if ( count == 0 ) {
+            refill();
+        }
+        uint8_t res = bits >> 31;
+        skip(1);
         return res;
     }
 
+    /* reads up to 8 bits */
     uint8_t readBits(uint8_t len) {
-
-        uint16_t end_offset = (bitpos + len - 1)>>3;
-        if ( end_offset >= size ) {
-            return 0;
+        if ( count < len ) {
+            refill();
         }
-
-        uint8_t i;
-        uint16_t byte_offset = bitpos >> 3;
-        if (byte_offset == end_offset) {
-            uint16_t x = pgm_read_byte_near(data + byte_offset);
-            i = (uint8_t)(x >> (8 - ((bitpos & 7) + len))) & ((1 << len) - 1);
-        } else {
-            uint16_t x = ((uint16_t)pgm_read_byte_near(data + byte_offset) << 8) + pgm_read_byte_near(data + end_offset);
-            i = (uint8_t)(x >> (16 - ((bitpos & 7) + len))) & ((1 << len) - 1);
-        }
-        bitpos += len;
-        return i;
+        uint8_t res = (uint8_t)(bits >> 24) >> (8 - len);
+        skip(len);
+        return res;
     }
 
+    /*
+     * reads a number of 2 - 255 range: n (0 - 5) one bits and a zero bit followed by n + 1 bits of
+     * the number above 2^(n + 1), or 6 one bits followed by 7 bits of the number above 128
+     */
     uint16_t readNumber() {
-        int16_t count;
-
-        int8_t ctr = 1;
-        int16_t base = 2;
-        do {
-            if ( readBit() == 0 ) {
-                uint8_t bits = readBits(ctr);
-                count = base + bits;
-                break;
-            } else {
-                ctr++;
-                base *= 2;
-                if ( ctr == 7 ) {
-                    uint8_t bits = readBits(ctr);
-                    count = base + bits;
-                    break;
-                }
-            }
-        } while ( true );
+        // leading zeros of a nibble
+        static const uint8_t nibbleZeros[16] = {4, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+        if ( count < 13 ) {
+            refill();
+        }
+        uint8_t inverse = ~(uint8_t)(bits >> 24) | 0x02; // a count of leading ones up to 6
+        uint8_t ones = inverse > 0x0f ? nibbleZeros[inverse >> 4] : 4 + nibbleZeros[inverse];
 
-        return (uint16_t)count;
+        skip(ones < 6 ? ones + 1 : ones);
+        return (2 << ones) + readBits(ones + 1);
     }
 };
 
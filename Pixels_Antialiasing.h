@@ -25,6 +25,37 @@
 #ifndef PIXELS_ANTIALIASING_H
 #define PIXELS_ANTIALIASING_H
 
+/*
+ * Antialiasing arithmetic is done in fixed point: coordinates along a line are 16.16 values,
+ * pixel coverage is 0..255 (0 - not covered, 255 - fully covered)
+ */
+#define FIXED_SHIFT 16
+#define FIXED_IPART(X) ((int16_t)((X) >> FIXED_SHIFT))
+#define FIXED_FPART8(X) ((uint8_t)((X) >> (FIXED_SHIFT - 8)))
+
+#ifndef AA_SPAN_LENGTH
+#define AA_SPAN_LENGTH 16 // max number of line steps blended with a single video memory read/write
+#endif
+
+/*
+ * Outline pixels collected into a rectangle of up to BLEND_BUFFER_SIZE pixels, so they are blended
+ * with one video memory read and write. The pixels of the rectangle not set have 0 coverage and
+ * are written back unchanged
+ */
+class BlendBatch {
+public:
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+    uint8_t alpha[BLEND_BUFFER_SIZE];
+
+    BlendBatch() {
+        x1 = y1 = 0;
+        x2 = y2 = -1;
+    }
+};
+
 class PixelsAntialiased : public PixelsBase {
 protected:
     virtual void drawCircleAntialiaced(int16_t x, int16_t y, int16_t radius, boolean bordermode);
@@ -32,6 +63,22 @@ protected:
     virtual void drawLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     virtual void drawRoundRectangleAntialiased(int16_t x, int16_t y, int16_t width, int16_t height, int16_t rx, int16_t ry, boolean bordermode);
 
+    /* blends length pairs of (upper, lower) line pixel coverages stepping from (x, y) along the line */
+    void blendSpan(int16_t x, int16_t y, boolean steep, uint8_t* alpha, int16_t length);
+    /* adds a pixel to a batch, blending the batch first if the pixel does not fit; without
+       video memory read the pixel is blended at once */
+    void batchPixel(BlendBatch& batch, int16_t x, int16_t y, uint8_t alpha);
+    void flushBatch(BlendBatch& batch);
+
+    /* integer square root of a value (rounded down) */
+    static uint16_t isqrt(uint32_t value);
+    /* num/den ratio (den != 0) scaled to 0..255 coverage range */
+    static uint8_t coverage(int32_t num, int32_t den);
+#ifdef ENABLE_FAT_LINES
+    /* coverage of a pixel at err distance from a line of ed length and wd half width (8.8 fixed point) */
+    static uint8_t fatLineCoverage(int32_t err, int32_t ed, int32_t wd);
+#endif
+
 public:
     virtual void enableAntialiasing(boolean enable) {
         antialiasing = enable;
@@ -41,6 +88,55 @@ public:
     }
 };
 
+uint16_t PixelsAntialiased::isqrt(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+    while ( bit > value ) {
+        bit >>= 2;
+    }
+    while ( bit != 0 ) {
+        if ( value >= result + bit ) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)result;
+}
+
+uint8_t PixelsAntialiased::coverage(int32_t num, int32_t den) {
+    if ( num < 0 ) {
+        num = -num;
+    }
+    if ( den < 0 ) {
+        den = -den;
+    }
+    if ( num >= den ) {
+        return 0xff;
+    }
+    // keep num * 255 within 32 bits
+    while ( den > 0x7fffff ) {
+        num >>= 1;
+        den >>= 1;
+    }
+    return (uint8_t)(num * 255 / den);
+}
+
+#ifdef ENABLE_FAT_LINES
+uint8_t PixelsAntialiased::fatLineCoverage(int32_t err, int32_t ed, int32_t wd) {
+    if ( err < 0 ) {
+        err = -err;
+    }
+    int32_t v = (err << 16) / ed - wd + 256;
+    if ( v <= 0 ) {
+        return 0xff;
+    }
+    return v >= 256 ? 0 : (uint8_t)(256 - v);
+}
+#endif
+
 void PixelsAntialiased::drawLineAntialiased(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     boolean steep = (y2 > y1 ? y2 - y1 : y1 - y2) > (x2 > x1 ? x2 - x1 : x1 - x2);
@@ -62,29 +158,113 @@ void PixelsAntialiased::drawLineAntialiased(int16_t x1, int16_t y1, int16_t x2,
     }
     int16_t deltax = x2 - x1;
     int16_t deltay = y2 - y1;
-    double gradient = 1.0 * deltay / deltax;
-
-    int16_t xend = x1; // round(x1);
-    double yend = y1 + gradient * (xend - x1);
-    double xgap = rfpart(x1 + 0.5);
-    int16_t xpxl1 = xend;
-    int16_t ypxl1 = ipart(yend);
-    putColor(xpxl1, ypxl1, steep, rfpart(yend)*xgap);
-    putColor(xpxl1, ypxl1 + 1, steep, fpart(yend)*xgap);
-    double intery = yend + gradient;
-
-    xend = x2; // round(x2);
-    yend = y2 + gradient * (xend - x2);
-    xgap = rfpart(x2 + 0.5);
-    int16_t xpxl2 = xend;
-    int16_t ypxl2 = ipart(yend);
-    putColor(xpxl2, ypxl2, steep, rfpart(yend)*xgap);
-    putColor(xpxl2, ypxl2 + 1, steep, fpart(yend)*xgap);
-
-    for ( int16_t x = xpxl1 + 1; x < xpxl2 - 1; x++ ) {
-          putColor(x, ipart(intery), steep, rfpart(intery));
-          putColor(x, ipart(intery) + 1, steep, fpart(intery));
-          intery += gradient;
+    if ( deltax == 0 ) {
+        putColor(x1, y1, steep, 0xff);
+        return;
+    }
+    int32_t gradient = ((int32_t)deltay << FIXED_SHIFT) / deltax;
+
+    // endpoints are integer, so they are half covered horizontally (xgap = 0.5) and fully covered vertically
+    putColor(x1, y1, steep, 0x80);
+    putColor(x2, y2, steep, 0x80);
+
+    // line steps sharing the same y are blended as a whole
+    uint8_t span[2 * AA_SPAN_LENGTH];
+    int16_t spanX = 0;
+    int16_t spanY = 0;
+    int16_t spanLength = 0;
+
+    int32_t intery = ((int32_t)y1 << FIXED_SHIFT) + gradient;
+    for ( int16_t x = x1 + 1; x < x2; x++ ) {
+        int16_t y = FIXED_IPART(intery);
+        uint8_t f = FIXED_FPART8(intery);
+        if ( spanLength > 0 && (y != spanY || spanLength == AA_SPAN_LENGTH) ) {
+            blendSpan(spanX, spanY, steep, span, spanLength);
+            spanLength = 0;
+        }
+        if ( spanLength == 0 ) {
+            spanX = x;
+            spanY = y;
+        }
+        span[2 * spanLength] = 0xff - f;
+        span[2 * spanLength + 1] = f;
+        spanLength++;
+        intery += gradient;
+    }
+    if ( spanLength > 0 ) {
+        blendSpan(spanX, spanY, steep, span, spanLength);
+    }
+}
+
+void PixelsAntialiased::blendSpan(int16_t x, int16_t y, boolean steep, uint8_t* alpha, int16_t length) {
+    if ( steep ) {
+        // (upper, lower) pairs are already rows of a 2 pixel wide region
+        blendRegion(y, x, y + 1, x + length - 1, alpha);
+    } else {
+        uint8_t rows[2 * AA_SPAN_LENGTH];
+        for ( int16_t i = 0; i < length; i++ ) {
+            rows[i] = alpha[2 * i];
+            rows[length + i] = alpha[2 * i + 1];
+        }
+        blendRegion(x, y, x + length - 1, y + 1, rows);
+    }
+}
+
+void PixelsAntialiased::batchPixel(BlendBatch& batch, int16_t x, int16_t y, uint8_t alpha) {
+
+    if ( alpha == 0 || x < 0 || x >= width || y < 0 || y >= height ) {
+        return;
+    }
+
+#ifndef PIXELS_MONOCHROME
+    if ( canReadBack() ) {
+        int16_t w = batch.x2 - batch.x1 + 1;
+        if ( batch.x2 < batch.x1 ) {
+            batch.x1 = batch.x2 = x;
+            batch.y1 = batch.y2 = y;
+            batch.alpha[0] = alpha;
+            return;
+        }
+
+        int16_t nx1 = min(batch.x1, x);
+        int16_t ny1 = min(batch.y1, y);
+        int16_t nx2 = max(batch.x2, x);
+        int16_t ny2 = max(batch.y2, y);
+        int16_t nw = nx2 - nx1 + 1;
+        boolean inside = nw == w && ny1 == batch.y1 && ny2 == batch.y2;
+        if ( (int32_t)nw * (ny2 - ny1 + 1) > BLEND_BUFFER_SIZE ||
+                (inside && batch.alpha[(y - ny1) * nw + x - nx1] != 0) ) {
+            // a pixel covered twice is blended twice, as putColor() would do
+            flushBatch(batch);
+            batch.x1 = batch.x2 = x;
+            batch.y1 = batch.y2 = y;
+            batch.alpha[0] = alpha;
+            return;
+        }
+
+        if ( !inside ) {
+            uint8_t grown[BLEND_BUFFER_SIZE];
+            memset(grown, 0, nw * (ny2 - ny1 + 1));
+            for ( int16_t r = 0; r <= batch.y2 - batch.y1; r++ ) {
+                memcpy(grown + (r + batch.y1 - ny1) * nw + batch.x1 - nx1, batch.alpha + r * w, w);
+            }
+            memcpy(batch.alpha, grown, nw * (ny2 - ny1 + 1));
+            batch.x1 = nx1;
+            batch.y1 = ny1;
+            batch.x2 = nx2;
+            batch.y2 = ny2;
+        }
+        batch.alpha[(y - ny1) * nw + x - nx1] = alpha;
+        return;
+    }
+#endif
+    putColor(x, y, false, alpha);
+}
+
+void PixelsAntialiased::flushBatch(BlendBatch& batch) {
+    if ( batch.x2 >= batch.x1 ) {
+        blendTile(batch.x1, batch.y1, batch.x2, batch.y2, batch.alpha, batch.x2 - batch.x1 + 1);
+        batch.x2 = batch.x1 - 1;
     }
 }
 
@@ -92,8 +272,6 @@ void PixelsAntialiased::drawFatLineAntialiased(int16_t x1, int16_t y1, int16_t x
 #ifdef ENABLE_FAT_LINES
 // the code still needs to be completed. Problems by line caps
 
-    double wd = lineWidth;
-
     int16_t dx = abs(x2 - x1);
     int16_t sx = x1 < x2 ? 1 : -1;
     int16_t dy = abs(y2 - y1);
@@ -104,17 +282,19 @@ void PixelsAntialiased::drawFatLineAntialiased(int16_t x1, int16_t y1, int16_t x
     int16_t x;
     int16_t y;
 
-    double ed = dx + dy == 0 ? 1 : sqrt((double) dx * dx + (double) dy * dy);
+    // line length and half width in 8.8 fixed point
+    int32_t ed = dx + dy == 0 ? 256 : ((int32_t)isqrt(((uint32_t)dx * dx + (uint32_t)dy * dy) << 8) << 4);
+    int32_t wd = (int32_t)(lineWidth * 128) + 128;
 
-    wd = (wd + 1) / 2;
+    BlendBatch batch;
     while ( true ) {
-        putColor(x1, y1, false, 1 - max(0, abs(err-dx+dy)/ed - wd + 1));
+        batchPixel(batch, x1, y1, fatLineCoverage(err - dx + dy, ed, wd));
         e2 = err;
         x = x1;
         boolean out = false;
         if (2 * e2 >= -dx) { /* x step */
-            for (e2 += dy, y = y1; e2 < ed * wd && (y2 != y || dx > dy); e2 += dx) {
-                putColor(x1, y += sy, false, 1 - max(0, abs(e2)/ed - wd + 1));
+            for (e2 += dy, y = y1; ((int32_t)e2 << 8) < ed * wd >> 8 && (y2 != y || dx > dy); e2 += dx) {
+                batchPixel(batch, x1, y += sy, fatLineCoverage(e2, ed, wd));
             }
             if (x1 == x2) {
                 out = true;
@@ -124,8 +304,8 @@ void PixelsAntialiased::drawFatLineAntialiased(int16_t x1, int16_t y1, int16_t x
             x1 += sx;
         }
         if (2 * e2 <= dy) { /* y step */
-            for (e2 = dx - e2; e2 < ed * wd && (x2 != x || dx < dy); e2 += dy) {
-                putColor(x += sx, y1, false, 1 - max(0, abs(e2)/ed - wd + 1));
+            for (e2 = dx - e2; ((int32_t)e2 << 8) < ed * wd >> 8 && (x2 != x || dx < dy); e2 += dy) {
+                batchPixel(batch, x += sx, y1, fatLineCoverage(e2, ed, wd));
             }
             if (y1 == y2) {
                 out = true;
@@ -137,6 +317,7 @@ void PixelsAntialiased::drawFatLineAntialiased(int16_t x1, int16_t y1, int16_t x
             break;
         }
     }
+    flushBatch(batch);
 #else
     drawLineAntialiased(x1, y1, x2, y2);
 #endif
@@ -147,9 +328,10 @@ void PixelsAntialiased::drawRoundRectangleAntialiased(int16_t x, int16_t y, int1
     int16_t i;
     int32_t a2, b2, ds, dt, dxt, t, s, d;
     int16_t xp, yp, xs, ys, dyt, od, xx, yy, xc2, yc2;
-    float cp;
-    double sab;
-    double weight, iweight;
+    uint16_t sab;
+    uint8_t weight, iweight;
+    // the upper left, upper right, lower left and lower right arcs
+    BlendBatch arcs[4];
 
     if ((rx < 0) || (ry < 0)) {
         return;
@@ -165,8 +347,8 @@ void PixelsAntialiased::drawRoundRectangleAntialiased(int16_t x, int16_t y, int1
         return;
     }
 
-    a2 = rx * rx;
-    b2 = ry * ry;
+    a2 = (int32_t)rx * rx;
+    b2 = (int32_t)ry * ry;
 
     ds = a2 << 1;
     dt = b2 << 1;
@@ -174,9 +356,10 @@ void PixelsAntialiased::drawRoundRectangleAntialiased(int16_t x, int16_t y, int1
     xc2 = x << 1;
     yc2 = y << 1;
 
-    sab = sqrt((double)(a2 + b2));
-    od = (int)iround(sab*0.01) + 1;
-    dxt = (int)iround((double)a2 / sab) + od;
+    // sqrt(a2 + b2) with 4 fraction bits
+    sab = isqrt((uint32_t)(a2 + b2) << 8);
+    od = (sab + 800) / 1600 + 1;
+    dxt = ((a2 << 4) + (sab >> 1)) / sab + od;
 
     t = 0;
     s = -2 * a2 * ry;
@@ -214,43 +397,34 @@ void PixelsAntialiased::drawRoundRectangleAntialiased(int16_t x, int16_t y, int1
 
         t -= dt;
 
-        if (s != 0) {
-            cp = (float) abs(d) / (float) abs(s);
-            if (cp > 1.0) {
-                cp = 1.0f;
-            }
-        } else {
-            cp = 1.0f;
-        }
-
-        weight = cp;
-        iweight = 1 - weight;
+        weight = s != 0 ? coverage(d, s) : 0xff;
+        iweight = 0xff - weight;
 
         if( bordermode ) {
-            iweight = yp > ys ? 1 : iweight;
-            weight = ys > yp ? 1 : weight;
+            iweight = yp > ys ? 0xff : iweight;
+            weight = ys > yp ? 0xff : weight;
         }
 
         /* Upper half */
         xx = xc2 - xp;
-        putColor(xp, yp, false, iweight);
-        putColor(xx+width, yp, false, iweight);
+        batchPixel(arcs[0], xp, yp, iweight);
+        batchPixel(arcs[1], xx+width, yp, iweight);
 
-        putColor(xp, ys, false, weight );
-        putColor(xx+width, ys, false, weight);
+        batchPixel(arcs[0], xp, ys, weight);
+        batchPixel(arcs[1], xx+width, ys, weight);
 
         /* Lower half */
         yy = yc2 - yp;
-        putColor(xp, yy+height, false, iweight);
-        putColor(xx+width, yy+height, false, iweight);
+        batchPixel(arcs[2], xp, yy+height, iweight);
+        batchPixel(arcs[3], xx+width, yy+height, iweight);
 
         yy = yc2 - ys;
-        putColor(xp, yy+height, false, weight);
-        putColor(xx+width, yy+height, false, weight);
+        batchPixel(arcs[2], xp, yy+height, weight);
+        batchPixel(arcs[3], xx+width, yy+height, weight);
     }
 
     /* Replaces original approximation code dyt = abs(yp - yc); */
-    dyt = (int)iround((double)b2 / sab ) + od;
+    dyt = ((b2 << 4) + (sab >> 1)) / sab + od;
 
     for (i = 1; i <= dyt; i++) {
         yp++;
@@ -276,34 +450,29 @@ void PixelsAntialiased::drawRoundRectangleAntialiased(int16_t x, int16_t y, int1
 
         s += ds;
 
-        if (t != 0) {
-            cp = (float) abs(d) / (float) abs(t);
-            if (cp > 1.0) {
-                cp = 1.0f;
-            }
-        } else {
-            cp = 1.0f;
-        }
-
-        weight = cp;
-        iweight = 1 - weight;
+        weight = t != 0 ? coverage(d, t) : 0xff;
+        iweight = 0xff - weight;
 
         /* Left half */
         xx = xc2 - xp;
         yy = yc2 - yp;
-        putColor(xp, yp, false, iweight);
-        putColor(xx+width, yp, false, iweight);
+        batchPixel(arcs[0], xp, yp, iweight);
+        batchPixel(arcs[1], xx+width, yp, iweight);
 
-        putColor(xp, yy+height, false, iweight);
-        putColor(xx+width, yy+height, false, iweight);
+        batchPixel(arcs[2], xp, yy+height, iweight);
+        batchPixel(arcs[3], xx+width, yy+height, iweight);
 
         /* Right half */
         xx = xc2 - xs;
-        putColor(xs, yp, false, weight);
-        putColor(xx+width, yp, false, weight);
+        batchPixel(arcs[0], xs, yp, weight);
+        batchPixel(arcs[1], xx+width, yp, weight);
+
+        batchPixel(arcs[2], xs, yy+height, weight);
+        batchPixel(arcs[3], xx+width, yy+height, weight);
+    }
 
-        putColor(xs, yy+height, false, weight);
-        putColor(xx+width, yy+height, false, weight);
+    for ( i = 0; i < 4; i++ ) {
+        flushBatch(arcs[i]);
     }
 }
 
@@ -0,0 +1,451 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * The code is written in C/C++ for Arduino and can be easily ported to any microcontroller by rewritting the low level pin access functions.
+ *
+ * Text output methods of the library rely on Pixelmeister's font data format. See: http://pd4ml.com/pixelmeister
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ *
+ * This library includes some code portions and algoritmic ideas derived from works of
+ * - Andreas Schiffler -- aschiffler at ferzkopp dot net (SDL_gfx Project)
+ * - K. Townsend http://microBuilder.eu (lpc1343codebase Project)
+ */
+
+/*
+ * Off-screen canvas: the graphics primitives render into RAM. A complete canvas can be later
+ * drawn to a display with Pixels::blitCanvas(). The canvas does not need any bus or controller
+ * and can be used without Pixels_<CONTROLLER>.h, including a desktop host build (see Pixels_Host.h)
+ *
+ * Include the file after Pixels_Antialiasing.h to get antialiased primitives for the canvas
+ */
+
+#include "Pixels.h"
+
+#ifndef PIXELS_CANVAS_H
+#define PIXELS_CANVAS_H
+
+#define CANVAS_RGB565 0     // 2 bytes per pixel
+#define CANVAS_INDEXED 1    // 1 byte per pixel: an index in a 256 color palette (RGB 3-3-2 by default)
+#define CANVAS_MONOCHROME 2 // 1 bit per pixel, 8 pixels of a row per byte, most significant bit first
+
+#if defined(PIXELS_ANTIALIASING_H)
+#define PixelsBase PixelsAntialiased
+#endif
+
+class PixelsCanvas : public PixelsBase {
+protected:
+    uint8_t format;
+    uint8_t* buffer;
+    int16_t rowBytes;
+
+    /* a custom palette of CANVAS_INDEXED format (NULL - RGB 3-3-2) */
+    uint16_t* palette;
+    uint16_t paletteLength;
+    uint16_t lastColor; // the last color mapped to a palette index and the index
+    uint8_t lastIndex;
+
+    int16_t xx1, yy1, xx2, yy2; // current region
+    int16_t mx, my;
+
+    int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    void quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    void deviceWriteData(uint8_t high, uint8_t low);
+    /* the qualified call binds statically, so the per-pixel code inlines into the loops */
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        while ( n-- > 0 ) {
+            PixelsCanvas::deviceWriteData(highByte(*data), lowByte(*data));
+            data++;
+        }
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        while ( n-- > 0 ) {
+            PixelsCanvas::deviceWriteData(highByte(color), lowByte(color));
+        }
+    }
+
+    boolean canReadRegion() {
+        return true;
+    }
+    boolean beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    uint16_t deviceReadData();
+
+    /* no chip to select */
+    void beginGfxOperation() {
+        gfxOpNestingDepth++;
+    }
+
+    void endGfxOperation(boolean force) {
+        gfxOpNestingDepth--;
+        if ( gfxOpNestingDepth < 0 ) {
+            gfxOpNestingDepth = 0;
+        }
+    }
+
+    uint8_t toIndex(uint16_t color);
+    void writeDevicePixel(int16_t x, int16_t y, uint16_t color);
+    uint16_t readDevicePixel(int16_t x, int16_t y);
+
+private:
+    /* the canvas owns its buffer, so it is not copied */
+    PixelsCanvas(const PixelsCanvas& canvas);
+    PixelsCanvas& operator=(const PixelsCanvas& canvas);
+
+public:
+    /**
+     * Constructs a new off-screen canvas and allocates its buffer.
+     * @param width canvas width (in pixels)
+     * @param height canvas height (in pixels)
+     * @param format CANVAS_RGB565, CANVAS_INDEXED or CANVAS_MONOCHROME
+     */
+    PixelsCanvas(uint16_t width, uint16_t height, uint8_t format = CANVAS_RGB565);
+    ~PixelsCanvas();
+    /**
+     * @return the pixel format given to the constructor
+     */
+    inline uint8_t getFormat() {
+        return format;
+    }
+    /**
+     * Gives a direct access to the canvas pixels: device rows (the canvas in PORTRAIT orientation)
+     * one by one, each getBufferRowBytes() long.
+     * @return the canvas memory or NULL if it could not be allocated
+     */
+    inline uint8_t* getBuffer() {
+        return buffer;
+    }
+    /**
+     * @return byte length of a device row in the canvas memory
+     */
+    inline int16_t getBufferRowBytes() {
+        return rowBytes;
+    }
+    /**
+     * Replaces the default RGB 3-3-2 palette of CANVAS_INDEXED canvas. Colors drawn to
+     * the canvas are mapped to the nearest palette entry.
+     * @param colors RGB565 colors (the array is not copied) or NULL to restore the default palette
+     * @param length number of the colors (up to 256)
+     */
+    void setPalette(uint16_t* colors, uint16_t length);
+    /**
+     * Reads a canvas pixel.
+     * @param x the <i>x</i> coordinate in the current coordinate space
+     * @param y the <i>y</i> coordinate in the current coordinate space
+     * @return RGB565 color of the pixel (white or black in CANVAS_MONOCHROME case)
+     */
+    uint16_t getPixel565(int16_t x, int16_t y);
+    /**
+     * Reads canvas pixels along a line: the first one at (x, y), each next one (stepX, stepY) away.
+     * Unlike getPixel565() the pixels are not checked to be within the canvas.
+     * @param x the <i>x</i> coordinate in the current coordinate space
+     * @param y the <i>y</i> coordinate in the current coordinate space
+     * @param stepX horizontal distance between two pixels
+     * @param stepY vertical distance between two pixels
+     * @param out receives RGB565 colors of the pixels
+     * @param n number of the pixels
+     */
+    void readPixels565(int16_t x, int16_t y, int8_t stepX, int8_t stepY, uint16_t* out, int16_t n);
+};
+
+PixelsCanvas::PixelsCanvas(uint16_t width, uint16_t height, uint8_t format) : PixelsBase(width, height) {
+    scrollSupported = false;
+
+    this->format = format;
+    switch ( format ) {
+    case CANVAS_INDEXED:
+        rowBytes = deviceWidth;
+        break;
+    case CANVAS_MONOCHROME:
+        rowBytes = (deviceWidth + 7) / 8;
+        break;
+    default:
+        this->format = CANVAS_RGB565;
+        rowBytes = deviceWidth * 2;
+        break;
+    }
+
+    buffer = (uint8_t*)malloc((int32_t)rowBytes * deviceHeight);
+    if ( buffer != NULL ) {
+        memset(buffer, 0, (int32_t)rowBytes * deviceHeight);
+    }
+
+    palette = NULL;
+    paletteLength = 0;
+    lastColor = 0;
+    lastIndex = 0;
+
+    xx1 = yy1 = xx2 = yy2 = 0;
+    mx = my = 0;
+}
+
+#if defined(PIXELS_ANTIALIASING_H)
+#undef PixelsBase
+#endif
+
+PixelsCanvas::~PixelsCanvas() {
+    free(buffer);
+}
+
+void PixelsCanvas::setPalette(uint16_t* colors, uint16_t length) {
+    palette = colors;
+    paletteLength = colors == NULL ? 0 : min(length, (uint16_t)256);
+    lastColor = 0;
+    lastIndex = toIndex(0);
+}
+
+uint8_t PixelsCanvas::toIndex(uint16_t color) {
+    if ( palette == NULL ) {
+        // R:3 G:3 B:2 most significant bits of RGB565
+        return ((color >> 8) & 0xe0) | ((color >> 6) & 0x1c) | ((color >> 3) & 0x03);
+    }
+
+    if ( color == lastColor ) {
+        return lastIndex;
+    }
+
+    int16_t r = color >> 11;
+    int16_t g = (color >> 5) & 0x3f;
+    int16_t b = color & 0x1f;
+    uint32_t best = 0xffffffff;
+    uint8_t index = 0;
+    for ( uint16_t i = 0; i < paletteLength; i++ ) {
+        uint16_t p = palette[i];
+        int16_t dr = (int16_t)(p >> 11) - r;
+        int16_t dg = (int16_t)((p >> 5) & 0x3f) - g;
+        int16_t db = (int16_t)(p & 0x1f) - b;
+        uint32_t d = (uint32_t)(4 * dr * dr + dg * dg + 4 * db * db);
+        if ( d < best ) {
+            best = d;
+            index = i;
+        }
+    }
+
+    lastColor = color;
+    lastIndex = index;
+    return index;
+}
+
+void PixelsCanvas::writeDevicePixel(int16_t x, int16_t y, uint16_t color) {
+    uint8_t* ptr = buffer + (int32_t)y * rowBytes;
+    switch ( format ) {
+    case CANVAS_RGB565:
+        ((uint16_t*)ptr)[x] = color;
+        break;
+    case CANVAS_INDEXED:
+        ptr[x] = toIndex(color);
+        break;
+    case CANVAS_MONOCHROME:
+        if ( (color & 0x8410) != 0 ) {
+            ptr[x >> 3] |= 0x80 >> (x & 7);
+        } else {
+            ptr[x >> 3] &= ~(0x80 >> (x & 7));
+        }
+        break;
+    }
+}
+
+int32_t PixelsCanvas::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    Bounds bb(x1, y1, x2, y2);
+    if( buffer == NULL || !checkBounds(bb) ) {
+        return 0;
+    }
+
+    xx1 = mx = bb.x1;
+    yy1 = my = bb.y1;
+    xx2 = bb.x2;
+    yy2 = bb.y2;
+
+    return 1;
+}
+
+inline void PixelsCanvas::deviceWriteData(uint8_t high, uint8_t low) {
+    writeDevicePixel(mx, my, ((uint16_t)high << 8) | low);
+
+    if ( ++mx > xx2 ) {
+        mx = xx1;
+        if ( ++my > yy2 ) {
+            my = yy1;
+        }
+    }
+}
+
+void PixelsCanvas::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    if ( setRegion(x1, y1, x2, y2) == 0 ) {
+        return;
+    }
+
+    int16_t length = xx2 - xx1 + 1;
+
+    switch ( format ) {
+    case CANVAS_RGB565:
+        for ( int16_t y = yy1; y <= yy2; y++ ) {
+            uint16_t* ptr = (uint16_t*)(buffer + (int32_t)y * rowBytes) + xx1;
+            for ( int16_t i = 0; i < length; i++ ) {
+                ptr[i] = color;
+            }
+        }
+        break;
+    case CANVAS_INDEXED:
+        {
+            uint8_t index = toIndex(color);
+            for ( int16_t y = yy1; y <= yy2; y++ ) {
+                memset(buffer + (int32_t)y * rowBytes + xx1, index, length);
+            }
+        }
+        break;
+    case CANVAS_MONOCHROME:
+        {
+            // first and last bytes of a row are partially covered
+            uint8_t fillByte = (color & 0x8410) != 0 ? 0xff : 0;
+            int16_t b1 = xx1 >> 3;
+            int16_t b2 = xx2 >> 3;
+            uint8_t mask1 = 0xff >> (xx1 & 7);
+            uint8_t mask2 = 0xff << (7 - (xx2 & 7));
+            if ( b1 == b2 ) {
+                mask1 &= mask2;
+            }
+            for ( int16_t y = yy1; y <= yy2; y++ ) {
+                uint8_t* ptr = buffer + (int32_t)y * rowBytes;
+                ptr[b1] = (ptr[b1] & ~mask1) | (fillByte & mask1);
+                if ( b2 > b1 ) {
+                    memset(ptr + b1 + 1, fillByte, b2 - b1 - 1);
+                    ptr[b2] = (ptr[b2] & ~mask2) | (fillByte & mask2);
+                }
+            }
+        }
+        break;
+    }
+}
+
+boolean PixelsCanvas::beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    return setRegion(x1, y1, x2, y2) != 0;
+}
+
+inline uint16_t PixelsCanvas::readDevicePixel(int16_t x, int16_t y) {
+    uint8_t* ptr = buffer + (int32_t)y * rowBytes;
+    uint16_t color;
+
+    switch ( format ) {
+    case CANVAS_INDEXED:
+        if ( palette != NULL ) {
+            color = ptr[x] < paletteLength ? palette[ptr[x]] : 0;
+        } else {
+            uint8_t i = ptr[x];
+            uint8_t r = i >> 5;
+            uint8_t g = (i >> 2) & 7;
+            uint8_t b = i & 3;
+            color = ((r << 2 | r >> 1) << 11) | ((g << 3 | g) << 5) | (b << 3 | b << 1 | b >> 1);
+        }
+        break;
+    case CANVAS_MONOCHROME:
+        color = (ptr[x >> 3] & (0x80 >> (x & 7))) != 0 ? 0xffff : 0;
+        break;
+    default:
+        color = ((uint16_t*)ptr)[x];
+        break;
+    }
+    return color;
+}
+
+uint16_t PixelsCanvas::deviceReadData() {
+    uint16_t color = readDevicePixel(mx, my);
+
+    if ( ++mx > xx2 ) {
+        mx = xx1;
+        if ( ++my > yy2 ) {
+            my = yy1;
+        }
+    }
+
+    return color;
+}
+
+uint16_t PixelsCanvas::getPixel565(int16_t x, int16_t y) {
+    if ( x < 0 || y < 0 || x >= width || y >= height ) {
+        return 0;
+    }
+
+    Bounds bb(x, y, x, y);
+    transformBounds(bb);
+    if ( !beginReadRegion(bb.x1, bb.y1, bb.x2, bb.y2) ) {
+        return 0;
+    }
+    return deviceReadData();
+}
+
+void PixelsCanvas::readPixels565(int16_t x, int16_t y, int8_t stepX, int8_t stepY, uint16_t* out, int16_t n) {
+    if ( buffer == NULL ) {
+        memset(out, 0, n * sizeof(uint16_t));
+        return;
+    }
+
+    // the line is mapped to device coordinates once: its start and the device step between two pixels
+    Bounds p(x, y, x, y);
+    Bounds q(x + stepX, y + stepY, x + stepX, y + stepY);
+    transformBounds(p);
+    transformBounds(q);
+    int16_t dx = q.x1 - p.x1;
+    int16_t dy = q.y1 - p.y1;
+
+    if ( format == CANVAS_RGB565 && dx == 1 && dy == 0 ) {
+        memcpy(out, (uint16_t*)(buffer + (int32_t)p.y1 * rowBytes) + p.x1, n * sizeof(uint16_t));
+        return;
+    }
+
+    int16_t px = p.x1;
+    int16_t py = p.y1;
+    for ( int16_t i = 0; i < n; i++ ) {
+        out[i] = readDevicePixel(px, py);
+        px += dx;
+        py += dy;
+    }
+}
+
+void PixelsBase::blitCanvas(int16_t x, int16_t y, PixelsCanvas* canvas) {
+    if ( canvas->getBuffer() == NULL ) {
+        return;
+    }
+
+    Bounds bb(x, y, x + canvas->getWidth() - 1, y + canvas->getHeight() - 1);
+
+    beginGfxOperation();
+
+    // RGB565 rows scanned in the canvas memory order are sent straight from the canvas memory,
+    // the other pixels are read a chunk at a time
+    boolean direct = canvas->getFormat() == CANVAS_RGB565 && canvas->getOrientation() == PORTRAIT;
+    uint16_t chunk[PIXEL_CHUNK_SIZE];
+
+    WindowScan scan;
+    for ( uint8_t part = 0; part < 2; part++ ) {
+        if ( !openWindow(bb, part, scan) ) {
+            continue;
+        }
+
+        int16_t rx = scan.x - x;
+        int16_t ry = scan.y - y;
+        for ( int16_t r = 0; r < scan.rows; r++ ) {
+            if ( direct && scan.colDx == 1 && scan.colDy == 0 ) {
+                deviceWritePixels((const uint16_t*)(canvas->getBuffer() + (int32_t)ry * canvas->getBufferRowBytes()) + rx,
+                                  scan.cols);
+            } else {
+                int16_t cx = rx;
+                int16_t cy = ry;
+                for ( int16_t c = 0; c < scan.cols; c += PIXEL_CHUNK_SIZE ) {
+                    int16_t n = min(scan.cols - c, PIXEL_CHUNK_SIZE);
+                    canvas->readPixels565(cx, cy, scan.colDx, scan.colDy, chunk, n);
+                    deviceWritePixels(chunk, n);
+                    cx += n * scan.colDx;
+                    cy += n * scan.colDy;
+                }
+            }
+            rx += scan.rowDx;
+            ry += scan.rowDy;
+        }
+    }
+
+    endGfxOperation();
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * The code is written in C/C++ for Arduino and can be easily ported to any microcontroller by rewritting the low level pin access functions.
+ *
+ * Text output methods of the library rely on Pixelmeister's font data format. See: http://pd4ml.com/pixelmeister
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ *
+ * This library includes some code portions and algoritmic ideas derived from works of
+ * - Andreas Schiffler -- aschiffler at ferzkopp dot net (SDL_gfx Project)
+ * - K. Townsend http://microBuilder.eu (lpc1343codebase Project)
+ */
+
+/*
+ * Image file sources for Pixels::loadBitmap():
+ *
+ * PixelsSDFile reads an SD card with Arduino SD library. Include <SD.h> before the file and
+ * initialize the card with SD.begin()
+ *
+ * PixelsPosixFile reads a file system of a desktop host (see Pixels_Host.h)
+ *
+ *     PixelsSDFile sd;
+ *     pxs.setFileSource(&sd);
+ *     pxs.loadBitmap(0, 0, 0, 0, "image.bmp");
+ */
+
+#include "Pixels.h"
+
+#ifndef PIXELS_FILES_H
+#define PIXELS_FILES_H
+
+#if defined(__SD_H__)
+class PixelsSDFile : public PixelsFileSource {
+private:
+    File file;
+
+public:
+    boolean open(const char* path) {
+        file = SD.open(path, FILE_READ);
+        return file;
+    }
+
+    int32_t read(uint8_t* buffer, int32_t length) {
+        return file.read(buffer, length);
+    }
+
+    boolean seek(uint32_t position) {
+        return file.seek(position);
+    }
+
+    void close() {
+        file.close();
+    }
+};
+#endif
+
+#if !defined(ARDUINO)
+#include <fcntl.h>
+#include <unistd.h>
+
+class PixelsPosixFile : public PixelsFileSource {
+private:
+    int fd;
+
+public:
+    PixelsPosixFile() {
+        fd = -1;
+    }
+
+    ~PixelsPosixFile() {
+        close();
+    }
+
+    boolean open(const char* path) {
+        close();
+        fd = ::open(path, O_RDONLY);
+        return fd >= 0;
+    }
+
+    int32_t read(uint8_t* buffer, int32_t length) {
+        return fd < 0 ? 0 : ::read(fd, buffer, length);
+    }
+
+    boolean seek(uint32_t position) {
+        return fd >= 0 && lseek(fd, position, SEEK_SET) == (off_t)position;
+    }
+
+    void close() {
+        if ( fd >= 0 ) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+#endif
+
+#endif
@@ -28,7 +28,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsHX8340 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -41,6 +41,12 @@ class Pixels : public PixelsBase
 {
 protected:
     void deviceWriteData(uint8_t high, uint8_t low);
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
@@ -49,13 +55,13 @@ protected:
     void scrollCmd();
 
 public:
-    Pixels() : PixelsBase(176, 220) { // Itead ITDB02-2.2SP as default
+    PixelsHX8340() : PixelsBase(176, 220) { // Itead ITDB02-2.2SP as default
         scrollSupported = true;
         setSpiPins(13, 11, 10, 7, 9); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase( width, height) {
+    PixelsHX8340(uint16_t width, uint16_t height) : PixelsBase( width, height) {
         scrollSupported = true;
         setSpiPins(13, 11, 10, 7 ,9); // dummy code in PPI case // uint8_t scl, uint8_t sda, uint8_t cs, uint8_t rst, uint8_t wr
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -68,7 +74,7 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsHX8340::init() {
 
     initInterface();
 
@@ -166,7 +172,7 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsHX8340::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
 
     writeCmd(0x37);
@@ -174,11 +180,11 @@ void Pixels::scrollCmd() {
     writeData(lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsHX8340::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsHX8340::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -187,37 +193,10 @@ void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi);writeData(lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsHX8340::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
@@ -239,8 +218,13 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
 
-void Pixels::deviceWriteData(uint8_t high, uint8_t low) {
+void PixelsHX8340::deviceWriteData(uint8_t high, uint8_t low) {
     writeData(high);
     writeData(low);
 }
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsHX8340> Pixels;
+#endif
 #endif
@@ -28,7 +28,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsHX8352 : public PixelsBase
 
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
@@ -42,6 +42,12 @@ class Pixels : public PixelsBase
 {
 protected:
     void deviceWriteData(uint8_t high, uint8_t low);
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
@@ -50,13 +56,13 @@ protected:
     void scrollCmd();
 
 public:
-    Pixels() : PixelsBase(240, 400) {
+    PixelsHX8352() : PixelsBase(240, 400) {
         scrollSupported = true;
         setSpiPins(13, 11, 10, 7, 9); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase( width, height) {
+    PixelsHX8352(uint16_t width, uint16_t height) : PixelsBase( width, height) {
         scrollSupported = true;
         setSpiPins(13, 11, 10, 7 ,9); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -69,7 +75,7 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsHX8352::init() {
 
     initInterface();
 
@@ -232,7 +238,7 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsHX8352::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
 //    int16_t s = (orientation < 2 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
 
@@ -242,11 +248,11 @@ void Pixels::scrollCmd() {
     writeData(lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsHX8352::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsHX8352::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -255,37 +261,10 @@ void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi, lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsHX8352::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
@@ -303,7 +282,12 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
 
-void Pixels::deviceWriteData(uint8_t high, uint8_t low) {
+void PixelsHX8352::deviceWriteData(uint8_t high, uint8_t low) {
     writeData(high, low);
 }
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsHX8352> Pixels;
+#endif
 #endif
@@ -0,0 +1,157 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * The code is written in C/C++ for Arduino and can be easily ported to any microcontroller by rewritting the low level pin access functions.
+ *
+ * Text output methods of the library rely on Pixelmeister's font data format. See: http://pd4ml.com/pixelmeister
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ *
+ * This library includes some code portions and algoritmic ideas derived from works of
+ * - Andreas Schiffler -- aschiffler at ferzkopp dot net (SDL_gfx Project)
+ * - K. Townsend http://microBuilder.eu (lpc1343codebase Project)
+ */
+
+/*
+ * The minimum of Arduino core API the library needs to be built outside of Arduino environment,
+ * i.e. with a plain C++ compiler on a desktop host to render into PixelsCanvas:
+ *
+ *     g++ -I<Pixels dir> sketch.cpp <Pixels dir>/Pixels.cpp
+ *
+ * Included by Pixels.h if ARDUINO is not defined
+ */
+
+#ifndef PIXELS_HOST_H
+#define PIXELS_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define PSTR(x) x
+
+#define pgm_read_byte(x)        (*((const uint8_t*)(x)))
+#define pgm_read_byte_near(x)   (*((const uint8_t*)(x)))
+#define pgm_read_byte_far(x)    (*((const uint8_t*)(x)))
+#define pgm_read_word(x)        (*((const uint16_t*)(x)))
+#define pgm_read_word_near(x)   (*((const uint16_t*)(x)))
+#define pgm_read_word_far(x)    (*((const uint16_t*)(x)))
+#define strlen_P(x)             strlen(x)
+
+class __FlashStringHelper;
+#define F(x) (reinterpret_cast<const __FlashStringHelper*>(x))
+
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+
+inline unsigned long micros() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long)t.tv_sec * 1000000UL + t.tv_nsec / 1000;
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    usleep(us);
+}
+
+inline void delay(unsigned long ms) {
+    usleep(ms * 1000);
+}
+
+/*
+ * Subset of Arduino String used by the library text API
+ */
+class String {
+private:
+    char* buffer;
+    unsigned int len;
+
+    void assign(const char* s, unsigned int n) {
+        char* b = (char*)malloc(n + 1);
+        memcpy(b, s, n);
+        b[n] = 0;
+        free(buffer);
+        buffer = b;
+        len = n;
+    }
+
+public:
+    String(const char* s = "") : buffer(NULL), len(0) {
+        assign(s, strlen(s));
+    }
+
+    String(const String& s) : buffer(NULL), len(0) {
+        assign(s.buffer, s.len);
+    }
+
+    ~String() {
+        free(buffer);
+    }
+
+    String& operator=(const String& s) {
+        if ( this != &s ) {
+            assign(s.buffer, s.len);
+        }
+        return *this;
+    }
+
+    inline unsigned int length() const {
+        return len;
+    }
+
+    inline char charAt(unsigned int i) const {
+        return i < len ? buffer[i] : 0;
+    }
+
+    inline char operator[](unsigned int i) const {
+        return charAt(i);
+    }
+
+    inline const char* c_str() const {
+        return buffer;
+    }
+
+    int indexOf(char c) const {
+        const char* p = strchr(buffer, c);
+        return p == NULL ? -1 : (int)(p - buffer);
+    }
+
+    String substring(unsigned int from, unsigned int to) const {
+        if ( to > len ) {
+            to = len;
+        }
+        if ( from > to ) {
+            from = to;
+        }
+        String s;
+        s.assign(buffer + from, to - from);
+        return s;
+    }
+
+    String substring(unsigned int from) const {
+        return substring(from, len);
+    }
+};
+
+#endif
@@ -31,7 +31,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsILI9325 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                             , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -44,22 +44,52 @@ class Pixels : public PixelsBase
 {
 protected:
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    boolean setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void setFillDirection(uint8_t direction);
 
     void scrollCmd();
 
+    void setScanOrientation(uint8_t direction);
+    void setWindow(Bounds wb, boolean line);
+
+    /* orientation the entry mode (R03) address counter directions are set for */
+    uint8_t scanOrientation;
+
+    /* window last sent to the controller (-1 if unknown) */
+    int16_t windowX1;
+    int16_t windowX2;
+    int16_t windowY1;
+    int16_t windowY2;
+
+#if defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+    boolean canReadRegion() {
+        return isReadable();
+    }
+    boolean beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    uint16_t deviceReadData();
+    void endReadRegion() {
+        endRead();
+    }
+#endif
+
     void deviceWriteData(uint8_t high, uint8_t low) {
         writeData(high, low);
     }
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 public:
-    Pixels() : PixelsBase(240, 320) { // TFT_PQ 2.4 + ITDB02 MEGA Shield v1.1 as defaults
+    PixelsILI9325() : PixelsBase(240, 320) { // TFT_PQ 2.4 + ITDB02 MEGA Shield v1.1 as defaults
         scrollSupported = true;
         setSpiPins(6, 7, 5, 3 ,4); // dummy code in PPI case // TODO
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase(width, height) {
+    PixelsILI9325(uint16_t width, uint16_t height) : PixelsBase(width, height) {
         scrollSupported = true;
         setSpiPins(6, 7, 5, 3 ,4); // dummy code in PPI case // TODO
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -72,7 +102,10 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsILI9325::init() {
+
+    windowX1 = windowX2 = windowY1 = windowY2 = -1;
+    scanOrientation = PORTRAIT;
 
     initInterface();
 
@@ -152,13 +185,13 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsILI9325::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
     writeCmd(0x6A);
     deviceWriteData(highByte(s), lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsILI9325::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 //    if ( order ) {
 //        writeCmdData(0x03, 0x1030);
@@ -167,7 +200,7 @@ void Pixels::setFillDirection(uint8_t direction) {
 //    }
 }
 
-void Pixels::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsILI9325::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -176,79 +209,96 @@ void Pixels::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    if ( lo == hi ) {
-        for (int16_t i = 0; i < counter / 20; i++) {
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-        }
-        for (int32_t i = 0; i < counter % 20; i++) {
-            writeDataTwice(lo);
-        }
-    } else {
-        for (int16_t i = 0; i < counter / 20; i++) {
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-        }
-        for (int32_t i = 0; i < counter % 20; i++) {
-            writeData(hi, lo);
-        }
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsILI9325::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
         return 0;
     }
 
+    setScanOrientation(PORTRAIT);
+    setWindow(bb, bb.y1 == bb.y2);
     writeCmdData(0x20, bb.x1);
     writeCmdData(0x21, bb.y1);
-    writeCmdData(0x50, bb.x1);
-    writeCmdData(0x52, bb.y1);
-    writeCmdData(0x51, bb.x2);
-    writeCmdData(0x53, bb.y2);
     writeCmd(0x22);
 
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
+
+boolean PixelsILI9325::setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    Bounds bb(x1, y1, x2, y2);
+    if( !checkBounds(bb) ) {
+        return false;
+    }
+
+    setScanOrientation(orientation);
+    setWindow(bb, orientation == PORTRAIT_FLIP ? bb.y1 == bb.y2 : bb.x1 == bb.x2);
+    // the address counter starts at the window corner the first logical row begins with
+    writeCmdData(0x20, orientation == LANDSCAPE_FLIP ? bb.x1 : bb.x2);
+    writeCmdData(0x21, orientation == LANDSCAPE ? bb.y1 : bb.y2);
+    writeCmd(0x22);
+
+    return true;
+}
+
+void PixelsILI9325::setScanOrientation(uint8_t direction) {
+    if ( direction == scanOrientation ) {
+        return;
+    }
+
+    // AM and ID[1:0] bits, ID0 steps horizontally and ID1 vertically: LANDSCAPE scans vertically down
+    // with rows moving to the left, PORTRAIT_FLIP horizontally backwards and LANDSCAPE_FLIP vertically up
+    // with rows moving to the right
+    static const uint16_t entryModes[] = {0x1030, 0x1028, 0x1000, 0x1018};
+    writeCmdData(0x03, entryModes[direction]);
+
+    scanOrientation = direction;
+}
+
+void PixelsILI9325::setWindow(Bounds wb, boolean line) {
+    if ( line ) {
+        // a single line along the address counter move direction needs the cursor only.
+        // Any window around the line does, so the current one is kept or the whole screen is used
+        if ( wb.x1 >= windowX1 && wb.x2 <= windowX2 && wb.y1 >= windowY1 && wb.y2 <= windowY2 ) {
+            return;
+        }
+        wb = Bounds(0, 0, deviceWidth - 1, deviceHeight - 1);
+    }
+    if ( wb.x1 != windowX1 || wb.x2 != windowX2 || wb.y1 != windowY1 || wb.y2 != windowY2 ) {
+        writeCmdData(0x50, wb.x1);
+        writeCmdData(0x52, wb.y1);
+        writeCmdData(0x51, wb.x2);
+        writeCmdData(0x53, wb.y2);
+        windowX1 = wb.x1;
+        windowX2 = wb.x2;
+        windowY1 = wb.y1;
+        windowY2 = wb.y2;
+    }
+}
+#if defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+boolean PixelsILI9325::beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    if ( !isReadable() || setRegion(x1, y1, x2, y2) == 0 ) {
+        return false;
+    }
+
+    beginRead();
+    readData(); // dummy read
+
+    return true;
+}
+
+uint16_t PixelsILI9325::deviceReadData() {
+    return readData();
+}
+#endif
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsILI9325> Pixels;
+#endif
 #endif
@@ -30,7 +30,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsILI9341 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -45,21 +45,54 @@ protected:
     void deviceWriteData(uint8_t high, uint8_t low) {
         writeData(high, low);
     }
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    boolean setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void setFillDirection(uint8_t direction);
 
     void scrollCmd();
 
+    void setScanOrientation(uint8_t direction);
+    void setAddressWindow(Bounds bb);
+
+    /* orientation the memory access mode (MADCTL) is set for */
+    uint8_t scanOrientation;
+
+    /* column and page address ranges last sent to the controller (-1 if unknown) */
+    int16_t windowX1;
+    int16_t windowX2;
+    int16_t windowY1;
+    int16_t windowY2;
+
+#if defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+    boolean canReadRegion() {
+        return isReadable();
+    }
+    boolean beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    uint16_t deviceReadData();
+    void endReadRegion() {
+        endRead();
+    }
+
+    /* the second pixel red component of 16bit memory read pair (-1 if none) */
+    int16_t readCarry;
+#endif
+
 public:
-    Pixels() : PixelsBase(240, 320) { // ElecFreaks TFT2.2SP shield as default
+    PixelsILI9341() : PixelsBase(240, 320) { // ElecFreaks TFT2.2SP shield as default
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase( width, height) {
+    PixelsILI9341(uint16_t width, uint16_t height) : PixelsBase( width, height) {
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -72,7 +105,10 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsILI9341::init() {
+
+    windowX1 = windowX2 = windowY1 = windowY2 = -1;
+    scanOrientation = PORTRAIT;
 
     initInterface();
 
@@ -185,18 +221,18 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsILI9341::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
     writeCmd(0x37);
     writeData(highByte(s));
     writeData(lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsILI9341::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsILI9341::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -205,55 +241,112 @@ void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi);writeData(lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsILI9341::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
         return 0;
     }
 
-    writeCmd(0x2a);
-    writeData(bb.x1>>8);
-    writeData(bb.x1);
-    writeData(bb.x2>>8);
-    writeData(bb.x2);
-    writeCmd(0x2b);
-    writeData(y1>>8);
-    writeData(bb.y1);
-    writeData(bb.y2>>8);
-    writeData(bb.y2);
-    writeCmd(0x2c);
+    setScanOrientation(PORTRAIT);
+    setAddressWindow(bb);
 
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
+
+boolean PixelsILI9341::setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    Bounds bb(x1, y1, x2, y2);
+    if( !checkBounds(bb) ) {
+        return false;
+    }
+
+    // in the memory access mode of the orientation column and page addresses are logical coordinates
+    untransformBounds(bb);
+    setScanOrientation(orientation);
+    setAddressWindow(bb);
+
+    return true;
+}
+
+void PixelsILI9341::setScanOrientation(uint8_t direction) {
+    if ( direction == scanOrientation ) {
+        return;
+    }
+
+    // row/column exchange and mirror bits (MV, MX, MY) toggled against the portrait mode
+    static const uint8_t modeBits[] = {0x00, 0x60, 0xC0, 0xA0};
+
+    writeCmd(0x36);
+    writeData(0x48 ^ modeBits[direction]);
+
+    scanOrientation = direction;
+    windowX1 = windowX2 = windowY1 = windowY2 = -1;
+}
+
+void PixelsILI9341::setAddressWindow(Bounds bb) {
+    // column or page address is sent only if it differs from the current one
+    if ( bb.x1 != windowX1 || bb.x2 != windowX2 ) {
+        writeCmd(0x2a);
+        writeData(bb.x1>>8);
+        writeData(bb.x1);
+        writeData(bb.x2>>8);
+        writeData(bb.x2);
+        windowX1 = bb.x1;
+        windowX2 = bb.x2;
+    }
+    if ( bb.y1 != windowY1 || bb.y2 != windowY2 ) {
+        writeCmd(0x2b);
+        writeData(bb.y1>>8);
+        writeData(bb.y1);
+        writeData(bb.y2>>8);
+        writeData(bb.y2);
+        windowY1 = bb.y1;
+        windowY2 = bb.y2;
+    }
+    writeCmd(0x2c);
+}
+#if defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+boolean PixelsILI9341::beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    if ( !isReadable() || setRegion(x1, y1, x2, y2) == 0 ) {
+        return false;
+    }
+
+    writeCmd(0x2e);
+    beginRead();
+    readDummy();
+    readCarry = -1;
+
+    return true;
+}
+
+uint16_t PixelsILI9341::deviceReadData() {
+    // memory read returns 18bit colors: R, G, B bytes with 6 significant bits each
+    uint8_t r, g, b;
+    if ( readCarry < 0 ) {
+        uint16_t rg = readData();
+        uint16_t br = readData();
+        r = highByte(rg);
+        g = lowByte(rg);
+        b = highByte(br);
+        readCarry = lowByte(br);
+    } else {
+        uint16_t gb = readData();
+        r = readCarry;
+        g = highByte(gb);
+        b = lowByte(gb);
+        readCarry = -1;
+    }
+    return ((uint16_t)(r & 0xf8) << 8) | ((uint16_t)(g & 0xfc) << 3) | (b >> 3);
+}
+#endif
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsILI9341> Pixels;
+#endif
 #endif
@@ -28,7 +28,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsILI9481 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -43,6 +43,12 @@ protected:
     void deviceWriteData(uint8_t high, uint8_t low) {
         writeData(high, low);
     }
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
@@ -51,13 +57,13 @@ protected:
     void scrollCmd();
 
 public:
-    Pixels() : PixelsBase(320, 480) { // ElecFreaks TFT2.2SP shield as default
+    PixelsILI9481() : PixelsBase(320, 480) { // ElecFreaks TFT2.2SP shield as default
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase( width, height) {
+    PixelsILI9481(uint16_t width, uint16_t height) : PixelsBase( width, height) {
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -70,7 +76,7 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsILI9481::init() {
 
     initInterface();
 
@@ -227,18 +233,18 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsILI9481::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
     writeCmd(0x37);
     writeData(highByte(s));
     writeData(lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsILI9481::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsILI9481::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -247,37 +253,10 @@ void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi, lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsILI9481::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
@@ -298,4 +277,9 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsILI9481> Pixels;
+#endif
 #endif
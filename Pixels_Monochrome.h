@@ -27,6 +27,11 @@
 
 #define DISABLE_ANTIALIASING 1
 
-// TODO add RGB() redefinition
+// PIXELS_MONOCHROME switches code in Pixels.cpp, which does not see the sketch includes, so a define here
+// would silently build the full color library. It is checked instead of set
+#include "Pixels.h"
+#ifndef PIXELS_MONOCHROME
+#error Pixels_Monochrome.h needs PIXELS_MONOCHROME: uncomment it in the Pixels.h config block or build with -DPIXELS_MONOCHROME
+#endif
 
 #endif
@@ -34,15 +34,22 @@
 #define DATAPORTL PORTC // 30-37
 #define DATADIRH DDRA
 #define DATADIRL DDRC
+#define DATAPINH PINA
+#define DATAPINL PINC
 #else
 // shortage of pins for non-Mega boards
 #define DATAPORTH PORTD // 0-7
 #define DATAPORTL PORTB // 8-13
 #define DATADIRH DDRD
 #define DATADIRL DDRB
+#define DATAPINH PIND
+#define DATAPINL PINB
 #endif
 
-class PPI16 {
+// keeps RD low long enough for a controller to put video memory data on the bus
+#define PPI_READ_DELAY() __asm__ __volatile__ ("nop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop")
+
+class PPI16 : public virtual PixelsChipSelect {
 private:
     regtype *registerRD;
     regtype *registerWR;
@@ -143,6 +150,73 @@ protected:
         writeData(highByte(data), lowByte(data));
     }
 
+    /* burst writes of n pixels, each sent as writeData(hi, lo) */
+    void writePixels(const uint16_t* data, uint32_t n) {
+        sbi(registerRS, bitmaskRS);
+        while ( n-- > 0 ) {
+            uint16_t color = *data++;
+#if defined(__arm__)
+            writeBus(highByte(color), lowByte(color));
+#else
+            DATAPORTH = highByte(color); DATAPORTL = lowByte(color); pulse_low(registerWR, bitmaskWR);
+#endif
+        }
+    }
+
+    void writeRepeat(uint16_t color, uint32_t n) {
+        if ( n == 0 ) {
+            return;
+        }
+        // the bus keeps the value, only WR is strobed
+        writeData(highByte(color), lowByte(color));
+        while ( --n > 0 ) {
+            pulse_low(registerWR, bitmaskWR);
+        }
+    }
+
+#if defined(__arm__)
+    // bus read is not implemented for Due pin mapping
+    boolean isReadable() {
+        return false;
+    }
+
+    void beginRead() {}
+    void readDummy() {}
+    uint16_t readData() {
+        return 0;
+    }
+    void endRead() {}
+#else
+    /* bus read is possible only if RD pin is assigned */
+    boolean isReadable() {
+        return pinRD > 0;
+    }
+
+    void beginRead() {
+        sbi(registerRS, bitmaskRS);
+        DATADIRH = 0x00;
+        DATADIRL = 0x00;
+    }
+
+    void readDummy() {
+        pulse_low(registerRD, bitmaskRD);
+    }
+
+    uint16_t readData() {
+        cbi(registerRD, bitmaskRD);
+        PPI_READ_DELAY();
+        uint8_t hi = DATAPINH;
+        uint8_t lo = DATAPINL;
+        sbi(registerRD, bitmaskRD);
+        return (hi << 8) | lo;
+    }
+
+    void endRead() {
+        DATADIRH = 0xFF;
+        DATADIRL = 0xFF;
+    }
+#endif
+
 public:
     /**
      * Overrides SPI pins
@@ -202,6 +276,10 @@ void PPI16::initInterface() {
     pinMode(pinWR,OUTPUT);
     pinMode(pinCS,OUTPUT);
     pinMode(pinRST,OUTPUT);
+    if ( pinRD > 0 ) {
+        pinMode(pinRD,OUTPUT);
+        sbi(registerRD, bitmaskRD);
+    }
 
 #if defined(__arm__)
     setDirectionRegisters();
@@ -30,12 +30,17 @@
 #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
 #define DATAPORT PORTA
 #define DATADIR DDRA
+#define DATAPIN PINA
 #else
 #define DATAPORT PORTD
 #define DATADIR DDRD
+#define DATAPIN PIND
 #endif
 
-class PPI8 {
+// keeps RD low long enough for a controller to put video memory data on the bus
+#define PPI_READ_DELAY() __asm__ __volatile__ ("nop\n\tnop\n\tnop\n\tnop\n\tnop\n\tnop")
+
+class PPI8 : public virtual PixelsChipSelect {
 private:
     regtype *registerRD;
     regtype *registerWR;
@@ -89,6 +94,56 @@ protected:
         writeData(highByte(data), lowByte(data));
     }
 
+    /* burst writes of n pixels, each sent as writeData(hi, lo) */
+    void writePixels(const uint16_t* data, uint32_t n) {
+        sbi(registerRS, bitmaskRS);
+        while ( n-- > 0 ) {
+            uint16_t color = *data++;
+            DATAPORT = highByte(color); pulse_low(registerWR, bitmaskWR); DATAPORT = lowByte(color); pulse_low(registerWR, bitmaskWR);
+        }
+    }
+
+    void writeRepeat(uint16_t color, uint32_t n) {
+        uint8_t hi = highByte(color);
+        uint8_t lo = lowByte(color);
+        sbi(registerRS, bitmaskRS);
+        if ( hi == lo ) {
+            // the bus keeps the value, only WR is strobed
+            DATAPORT = hi;
+            while ( n-- > 0 ) {
+                pulse_low(registerWR, bitmaskWR); pulse_low(registerWR, bitmaskWR);
+            }
+        } else {
+            while ( n-- > 0 ) {
+                DATAPORT = hi; pulse_low(registerWR, bitmaskWR); DATAPORT = lo; pulse_low(registerWR, bitmaskWR);
+            }
+        }
+    }
+
+    /* bus read is possible only if RD pin is assigned */
+    boolean isReadable() {
+        return pinRD > 0;
+    }
+
+    void beginRead() {
+        sbi(registerRS, bitmaskRS);
+        DATADIR = 0x00;
+    }
+
+    void readDummy() {
+        pulse_low(registerRD, bitmaskRD);
+    }
+
+    uint16_t readData() {
+        cbi(registerRD, bitmaskRD); PPI_READ_DELAY(); uint8_t hi = DATAPIN; sbi(registerRD, bitmaskRD);
+        cbi(registerRD, bitmaskRD); PPI_READ_DELAY(); uint8_t lo = DATAPIN; sbi(registerRD, bitmaskRD);
+        return (hi << 8) | lo;
+    }
+
+    void endRead() {
+        DATADIR = 0xFF;
+    }
+
 public:
     /**
      * Overrides SPI pins
@@ -143,6 +198,10 @@ void PPI8::initInterface() {
     pinMode(pinWR,OUTPUT);
     pinMode(pinCS,OUTPUT);
     pinMode(pinRST,OUTPUT);
+    if ( pinRD > 0 ) {
+        pinMode(pinRD,OUTPUT);
+        sbi(registerRD, bitmaskRD);
+    }
 
     reset();
 }
@@ -28,7 +28,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsS6D0164 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                             , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -49,14 +49,20 @@ protected:
     void deviceWriteData(uint8_t high, uint8_t low) {
         writeData(high, low);
     }
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 public:
-    Pixels() : PixelsBase(176, 220) { // TFT_PQ 2.4 + ITDB02 MEGA Shield v1.1 as defaults
+    PixelsS6D0164() : PixelsBase(176, 220) { // TFT_PQ 2.4 + ITDB02 MEGA Shield v1.1 as defaults
         scrollSupported = true;
         setSpiPins(6, 7, 5, 3 ,4); // dummy code in PPI case // TODO
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase(width, height) {
+    PixelsS6D0164(uint16_t width, uint16_t height) : PixelsBase(width, height) {
         scrollSupported = true;
         setSpiPins(6, 7, 5, 3 ,4); // dummy code in PPI case // TODO
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -69,7 +75,7 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsS6D0164::init() {
 
     initInterface();
 
@@ -135,14 +141,14 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsS6D0164::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
 //    int16_t s = (orientation < 2 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
     writeCmd(0x33);
     deviceWriteData(highByte(s), lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsS6D0164::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 //    if ( order ) {
 //        writeCmdData(0x03, 0x1030);
@@ -151,7 +157,7 @@ void Pixels::setFillDirection(uint8_t direction) {
 //    }
 }
 
-void Pixels::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsS6D0164::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -160,65 +166,10 @@ void Pixels::quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    if ( lo == hi ) {
-        for (int16_t i = 0; i < counter / 20; i++) {
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-            writeDataTwice(lo);
-        }
-        for (int32_t i = 0; i < counter % 20; i++) {
-            writeDataTwice(lo);
-        }
-    } else {
-        for (int16_t i = 0; i < counter / 20; i++) {
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-            writeData(hi, lo);
-        }
-        for (int32_t i = 0; i < counter % 20; i++) {
-            writeData(hi, lo);
-        }
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsS6D0164::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
@@ -235,4 +186,9 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsS6D0164> Pixels;
+#endif
 #endif
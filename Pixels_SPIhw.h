@@ -32,7 +32,7 @@
 //#undef chipDeselect
 //#define chipDeselect()
 
-class SPIhw {
+class SPIhw : public virtual PixelsChipSelect {
 private:
     uint8_t pinSCL;
     uint8_t pinSDA;
@@ -58,6 +58,13 @@ private:
     void updatectars();
     int spiModeRequest;
 
+#if !defined(TEENSYDUINO) && !defined(NO_SPI_PACKING)
+    /* 9-bit mode: eight data words (D/C=1 and a byte each) packed to the nine bytes of their bitstream */
+    void packData(const uint8_t* words, uint8_t* packed);
+    void writePacked(const uint8_t* packed);
+    boolean packable();
+#endif
+
 protected:
     void reset() {
         digitalWrite(pinRST,LOW);
@@ -85,6 +92,30 @@ protected:
         writeData(lowByte(data));
     }
 
+    /* burst writes of n pixels, each sent as writeData(hi, lo) */
+    void writePixels(const uint16_t* data, uint32_t n);
+    void writeRepeat(uint16_t color, uint32_t n);
+
+#if defined(PIXELS_TRANSFER_H) && defined(SPI_STC_vect) && !defined(TEENSYDUINO)
+    /* asynchronous transfers (see Pixels_Transfer.h) drained by the transfer complete interrupt */
+    static PixelsTransferQueue transferQueue;
+    static SPIhw* transferBus;
+    /* busy flag of the SPI peripheral, shared by the displays on it */
+    static volatile boolean transferActive;
+
+    boolean queuePixels(const uint16_t* data, uint32_t n, PixelsTransferDone done, void* context);
+    void startByte(uint8_t b, boolean command);
+    /* CPU clock cycles per SPI clock cycle */
+    uint8_t getSPIClockDivider();
+
+public:
+    SPIhw() {
+        transferBusy = &transferActive;
+    }
+
+    static void transferNext();
+#endif
+
 public:
     void setSPIBitOrder(uint8_t bitOrder);
     void setSPIDataMode(uint8_t mode);
@@ -208,6 +239,100 @@ void SPIhw::writeData(uint8_t data) {
 #endif
 }
 
+void SPIhw::writePixels(const uint16_t* data, uint32_t n) {
+#if !defined(TEENSYDUINO)
+    if ( eightBit ) {
+        // D/C stays high for the whole burst; the next pixel is fetched while a byte is being shifted out
+        *registerWR |= bitmaskWR;
+        while ( n-- > 0 ) {
+            uint16_t color = *data++;
+            SPDR = highByte(color);
+            uint8_t lo = lowByte(color);
+            while (!(SPSR & _BV(SPIF)));
+            SPDR = lo;
+            while (!(SPSR & _BV(SPIF)));
+        }
+        return;
+    }
+#if !defined(NO_SPI_PACKING)
+    if ( packable() ) {
+        // every four pixels go as one SPI burst instead of eight bit-banged D/C bits
+        uint8_t words[8];
+        uint8_t packed[9];
+        while ( n >= 4 ) {
+            for ( uint8_t i = 0; i < 8; i += 2 ) {
+                words[i] = highByte(*data);
+                words[i + 1] = lowByte(*data);
+                data++;
+            }
+            packData(words, packed);
+            writePacked(packed);
+            n -= 4;
+        }
+    }
+#endif
+#endif
+    while ( n-- > 0 ) {
+        writeData(highByte(*data), lowByte(*data));
+        data++;
+    }
+}
+
+void SPIhw::writeRepeat(uint16_t color, uint32_t n) {
+    uint8_t hi = highByte(color);
+    uint8_t lo = lowByte(color);
+#if !defined(TEENSYDUINO)
+    if ( eightBit ) {
+        *registerWR |= bitmaskWR;
+        while ( n-- > 0 ) {
+            SPDR = hi;
+            while (!(SPSR & _BV(SPIF)));
+            SPDR = lo;
+            while (!(SPSR & _BV(SPIF)));
+        }
+        return;
+    }
+#if !defined(NO_SPI_PACKING)
+    if ( packable() && n >= 4 ) {
+        // four pixels of the same color make the same nine bytes every time
+        uint8_t words[8] = {hi, lo, hi, lo, hi, lo, hi, lo};
+        uint8_t packed[9];
+        packData(words, packed);
+        while ( n >= 4 ) {
+            writePacked(packed);
+            n -= 4;
+        }
+    }
+#endif
+#endif
+    while ( n-- > 0 ) {
+        writeData(hi, lo);
+    }
+}
+
+#if !defined(TEENSYDUINO) && !defined(NO_SPI_PACKING)
+boolean SPIhw::packable() {
+    // the D/C bit leads each word, so the bitstream must go out most significant bit first
+    return !eightBit && !(SPCR & _BV(DORD));
+}
+
+void SPIhw::packData(const uint8_t* words, uint8_t* packed) {
+    // bitstream 1 w0 1 w1 ... 1 w7: byte i holds the last bits of word i-1, the D/C bit of word i and its first bits
+    packed[0] = 0x80 | (words[0] >> 1);
+    for ( uint8_t i = 1; i < 8; i++ ) {
+        packed[i] = (words[i - 1] << (8 - i)) | (0x80 >> i) | (words[i] >> (i + 1));
+    }
+    packed[8] = words[7];
+}
+
+void SPIhw::writePacked(const uint8_t* packed) {
+    for ( uint8_t i = 0; i < 9; i++ ) {
+        SPDR = packed[i];
+        while (!(SPSR & _BV(SPIF)));
+    }
+}
+#endif
+
 void SPIhw::beginSPI() {
 
     digitalWrite(pinCS, HIGH);
@@ -281,4 +406,87 @@ void SPIhw::setSPIClockDivider(uint8_t rate) {
 #endif
 }
 
+#if defined(PIXELS_TRANSFER_H) && defined(SPI_STC_vect) && !defined(TEENSYDUINO)
+PixelsTransferQueue SPIhw::transferQueue;
+SPIhw* SPIhw::transferBus = NULL;
+volatile boolean SPIhw::transferActive = false;
+
+ISR(SPI_STC_vect) {
+    SPIhw::transferNext();
+}
+
+boolean SPIhw::queuePixels(const uint16_t* data, uint32_t n, PixelsTransferDone done, void* context) {
+    if ( getSPIClockDivider() < TRANSFER_MIN_SPI_DIVIDER ) {
+        return false; // the interrupt would not keep up with the bus
+    }
+    while ( !transferQueue.enqueuePixels(data, n, done, context) ) {
+    }
+
+    uint8_t sreg = SREG;
+    cli();
+    if ( !transferActive ) {
+        // the first byte is sent here, every next one from the interrupt of the previous
+        transferActive = true;
+        transferBus = this;
+        SPCR |= _BV(SPIE);
+        transferNext();
+    }
+    SREG = sreg;
+    return true;
+}
+
+void SPIhw::transferNext() {
+    uint8_t value;
+    boolean command;
+    if ( transferQueue.next(value, command) ) {
+        transferBus->startByte(value, command);
+        return;
+    }
+
+    // the sent transfer is released and the bus goes on or gets free before the callback runs, so
+    // the callback can start the next transfer
+    PixelsTransferDone done = NULL;
+    void* context = NULL;
+    transferQueue.complete(done, context);
+    if ( transferQueue.next(value, command) ) {
+        transferBus->startByte(value, command);
+    } else {
+        SPCR &= ~_BV(SPIE);
+        transferActive = false;
+    }
+    if ( done != NULL ) {
+        done(context);
+    }
+}
+
+uint8_t SPIhw::getSPIClockDivider() {
+    // SPR1:SPR0 select 4, 16, 64 or 128; SPI2X halves it
+    uint8_t rate = SPCR & SPI_CLOCK_MASK;
+    uint8_t divider = rate == 3 ? 128 : 4 << (rate * 2);
+    return (SPSR & SPI_2XCLOCK_MASK) ? divider >> 1 : divider;
+}
+
+void SPIhw::startByte(uint8_t b, boolean command) {
+    // writeCmd() and writeData() without waiting for the transfer end
+    if ( eightBit ) {
+        if ( command ) {
+            *registerWR &= ~bitmaskWR;
+        } else {
+            *registerWR |= bitmaskWR;
+        }
+    } else {
+        SPCR &= ~_BV(SPE);
+        if ( command ) {
+            cbi(registerSDA, bitmaskSDA);
+        } else {
+            sbi(registerSDA, bitmaskSDA);
+        }
+        cbi(registerSCL, bitmaskSCL);
+        sbi(registerSCL, bitmaskSCL);
+        SPCR |= _BV(SPE);
+    }
+    SPDR = b;
+}
+#endif
+
 #endif // PIXELS_SPIHW_H
@@ -27,9 +27,7 @@
 #ifndef PIXELS_SPISW_H
 #define PIXELS_SPISW_H
 
-bool eightBit = true;
-
-class SPIsw {
+class SPIsw : public virtual PixelsChipSelect {
 private:
     uint8_t pinSCL;
     uint8_t pinSDA;
@@ -44,6 +42,9 @@ private:
     regsize bitmaskSDA;
     regsize bitmaskWR;
 
+    /* the display takes a WR (D/C) pin instead of a ninth bit per byte */
+    bool eightBit;
+
     void busWrite(uint8_t data);
 
 protected:
@@ -73,7 +74,15 @@ protected:
         writeData(lowByte(data));
     }
 
+    /* burst writes of n pixels, each sent as writeData(hi, lo) */
+    void writePixels(const uint16_t* data, uint32_t n);
+    void writeRepeat(uint16_t color, uint32_t n);
+
 public:
+    SPIsw() {
+        eightBit = true;
+    }
+
     void initInterface();
 
 //    void setSPIEightBit(bool bits) {
@@ -166,6 +175,42 @@ void SPIsw::writeCmd(uint8_t cmd) {
 #endif
 }
 
+void SPIsw::writePixels(const uint16_t* data, uint32_t n) {
+#if !defined(TEENSYDUINO)
+    if ( eightBit ) {
+        *registerWR |= bitmaskWR;
+        while ( n-- > 0 ) {
+            busWrite(highByte(*data));
+            busWrite(lowByte(*data));
+            data++;
+        }
+        return;
+    }
+#endif
+    while ( n-- > 0 ) {
+        writeData(highByte(*data), lowByte(*data));
+        data++;
+    }
+}
+
+void SPIsw::writeRepeat(uint16_t color, uint32_t n) {
+    uint8_t hi = highByte(color);
+    uint8_t lo = lowByte(color);
+#if !defined(TEENSYDUINO)
+    if ( eightBit ) {
+        *registerWR |= bitmaskWR;
+        while ( n-- > 0 ) {
+            busWrite(hi);
+            busWrite(lo);
+        }
+        return;
+    }
+#endif
+    while ( n-- > 0 ) {
+        writeData(hi, lo);
+    }
+}
+
 void SPIsw::writeData(uint8_t data) {
 #if defined(TEENSYDUINO)
     chipSelect();
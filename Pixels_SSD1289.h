@@ -28,7 +28,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsSSD1289 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -43,21 +43,44 @@ protected:
     void deviceWriteData(uint8_t high, uint8_t low) {
         writeData(high, low);
     }
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    boolean setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void setFillDirection(uint8_t direction);
 
     void scrollCmd();
 
+    void setScanOrientation(uint8_t direction);
+
+    /* orientation the entry mode (R11) address counter directions are set for */
+    uint8_t scanOrientation;
+
+#if defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+    boolean canReadRegion() {
+        return isReadable();
+    }
+    boolean beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    uint16_t deviceReadData();
+    void endReadRegion() {
+        endRead();
+    }
+#endif
+
 public:
-    Pixels() : PixelsBase(240, 320) { // ElecFreaks TFT2.2SP shield as default
+    PixelsSSD1289() : PixelsBase(240, 320) { // ElecFreaks TFT2.2SP shield as default
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase(width, height) {
+    PixelsSSD1289(uint16_t width, uint16_t height) : PixelsBase(width, height) {
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -70,7 +93,9 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsSSD1289::init() {
+
+    scanOrientation = PORTRAIT;
 
     initInterface();
 
@@ -122,62 +147,36 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsSSD1289::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
     writeCmd(0x41);
     deviceWriteData(highByte(s), lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsSSD1289::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsSSD1289::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
         return;
     }
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
     registerSelect();
 
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi, lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsSSD1289::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
         return 0;
     }
 
+    setScanOrientation(PORTRAIT);
     writeCmdData(0x44,(bb.x2<<8)+bb.x1);
     writeCmdData(0x45,bb.y1);
     writeCmdData(0x46,bb.y2);
@@ -188,4 +187,59 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
 
+boolean PixelsSSD1289::setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    Bounds bb(x1, y1, x2, y2);
+    if( !checkBounds(bb) ) {
+        return false;
+    }
+
+    setScanOrientation(orientation);
+    writeCmdData(0x44,(bb.x2<<8)+bb.x1);
+    writeCmdData(0x45,bb.y1);
+    writeCmdData(0x46,bb.y2);
+    // the address counter starts at the window corner the first logical row begins with
+    writeCmdData(0x4e, orientation == LANDSCAPE_FLIP ? bb.x1 : bb.x2);
+    writeCmdData(0x4f, orientation == LANDSCAPE ? bb.y1 : bb.y2);
+    writeCmd(0x22);
+
+    return true;
+}
+
+void PixelsSSD1289::setScanOrientation(uint8_t direction) {
+    if ( direction == scanOrientation ) {
+        return;
+    }
+
+    // AM and ID[1:0] bits, ID0 steps horizontally and ID1 vertically: LANDSCAPE scans vertically down
+    // with rows moving to the left, PORTRAIT_FLIP horizontally backwards and LANDSCAPE_FLIP vertically up
+    // with rows moving to the right
+    static const uint16_t entryModes[] = {0x6070, 0x6068, 0x6040, 0x6058};
+    writeCmdData(0x11, entryModes[direction]);
+
+    scanOrientation = direction;
+}
+
+#if defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+boolean PixelsSSD1289::beginReadRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    if ( !isReadable() || setRegion(x1, y1, x2, y2) == 0 ) {
+        return false;
+    }
+
+    beginRead();
+    readData(); // dummy read
+
+    return true;
+}
+
+uint16_t PixelsSSD1289::deviceReadData() {
+    return readData();
+}
+#endif
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsSSD1289> Pixels;
+#endif
 #endif
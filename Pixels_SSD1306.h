@@ -31,7 +31,17 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+/*
+ * A pixel is lit if any of the 565 colour components is above the half of its range, see LIT565().
+ * A monochrome build sets colors to 0 or 0xffff already, so only image data needs the threshold
+ */
+#ifdef PIXELS_MONOCHROME
+#define SSD1306_LIT(color) ((color) != 0)
+#else
+#define SSD1306_LIT(color) LIT565(color)
+#endif
+
+class PixelsSSD1306 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -44,6 +54,26 @@ class Pixels : public PixelsBase
 {
 protected:
     void deviceWriteData(uint8_t high, uint8_t low);
+    /* the qualified call binds statically, so the per-pixel code inlines into the loops */
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        while ( n-- > 0 ) {
+#ifdef PIXELS_MONOCHROME
+            // bitmaps and canvases carry RGB565 pixels
+            PixelsSSD1306::deviceWriteData(LIT565(*data), 0);
+#else
+            PixelsSSD1306::deviceWriteData(highByte(*data), lowByte(*data));
+#endif
+            data++;
+        }
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+#ifdef PIXELS_MONOCHROME
+        color = LIT565(color) ? 0xffff : 0;
+#endif
+        while ( n-- > 0 ) {
+            PixelsSSD1306::deviceWriteData(highByte(color), lowByte(color));
+        }
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
@@ -55,25 +85,38 @@ protected:
     int xx1, yy1, xx2, yy2; // current region
     int mx;
     int my;
+    uint8_t* writePtr; // frame buffer byte of the current pixel (mx, my)
+    uint8_t writeMask;
+
+    int16_t dirtyPage1, dirtyPage2, dirtyColumn1, dirtyColumn2; // frame buffer area changed since the last flush
+    int16_t flushedScroll; // scroll offset of the display memory contents (-1 if unknown)
+
+    void seekPixel();
+    void markDirty(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    void flushColumns(int16_t column1, int16_t column2, int16_t hwColumn);
 
 //    boolean checkBounds(Bounds& bb);
     void endGfxOperation(boolean force);
 
 public:
 
-    Pixels() : PixelsBase(128, 64) {
+    PixelsSSD1306() : PixelsBase(128, 64) {
         scrollSupported = true;
 //      setSpiPins(uint8_t scl, uint8_t sda, uint8_t cs, uint8_t rst, uint8_t wr = 255)
         setSpiPins(13, 11, 10, 5, 2);
         frameBuffer = new uint8_t[deviceWidth/8 * deviceHeight];
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase(width, height) {
+    PixelsSSD1306(uint16_t width, uint16_t height) : PixelsBase(width, height) {
         scrollSupported = true;
         setSpiPins(13, 11, 10, 5, 2); // dummy code in PPI case
         frameBuffer = new uint8_t[deviceWidth/8 * deviceHeight];
     }
 
+    ~PixelsSSD1306() {
+        delete[] frameBuffer;
+    }
+
     void init();
     int8_t drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, prog_uint16_t* data);
 };
@@ -82,7 +125,7 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsSSD1306::init() {
 
     initInterface();
 
@@ -155,75 +198,84 @@ void Pixels::init() {
 
     chipDeselect();
 
-    for ( int i = 0; i < deviceWidth * deviceHeight / 8; i++ ) {
-        frameBuffer[i] = 0;
-    }
+    memset(frameBuffer, 0, deviceWidth/8 * deviceHeight);
+
+    dirtyPage1 = 0;
+    dirtyPage2 = deviceWidth/8 - 1;
+    dirtyColumn1 = 0;
+    dirtyColumn2 = deviceHeight - 1;
+    flushedScroll = -1;
 }
 
-void Pixels::scrollCmd() {
+void PixelsSSD1306::scrollCmd() {
     // NOP
     // scrolling is emulated with the frame buffer
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsSSD1306::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
-
-    uint8_t r = ((0xf800 & color)>>11) * 255 / 31;
-    uint8_t g = ((0x7e0 & color)>>5) * 255 / 63;
-    uint8_t b = (0x1f & color) * 255 / 31;
-    boolean w = r > 127 || g > 127 || b > 127;;
+void PixelsSSD1306::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     if( !setRegion(x1, y1, x2, y2) ) {
         return;
     }
 
-    for ( int y = yy1; y <= yy2; y++ ) {
-        for ( int x = xx1; x <= xx2; x++ ) {
-            int idx = deviceHeight - y - 1 + (x/8) * deviceHeight;
-            if ( idx < 0 || idx >= deviceWidth/8 * deviceHeight ) {
-                continue;
-            }
-            if (w) {
-                frameBuffer[idx] |= (1 << (x&7));
-            } else {
-                frameBuffer[idx] &= ~(1 << (x&7));
+    uint8_t fillByte = SSD1306_LIT(color) ? 0xff : 0;
+
+    // a page holds 8 device columns (x) as bits of consecutive bytes along y, bottom up
+    int16_t column = deviceHeight - 1 - yy2;
+    int16_t length = yy2 - yy1 + 1;
+
+    for ( int16_t page = xx1 / 8; page <= xx2 / 8; page++ ) {
+        uint8_t* ptr = frameBuffer + page * deviceHeight + column;
+
+        uint8_t mask = 0xff;
+        if ( page == xx1 / 8 ) {
+            mask &= 0xff << (xx1 & 7);
+        }
+        if ( page == xx2 / 8 ) {
+            mask &= 0xff >> (7 - (xx2 & 7));
+        }
+
+        if ( mask == 0xff ) {
+            memset(ptr, fillByte, length);
+        } else {
+            uint8_t set = fillByte & mask;
+            mask = ~mask;
+            for ( int16_t i = 0; i < length; i++ ) {
+                ptr[i] = (ptr[i] & mask) | set;
             }
         }
     }
 }
 
-void Pixels::deviceWriteData(uint8_t high, uint8_t low) {
-    int color = (((uint16_t)high) << 8) + low;
-    uint8_t r = ((0xf800 & color)>>11) * 255 / 31;
-    uint8_t g = ((0x7e0 & color)>>5) * 255 / 63;
-    uint8_t b = (0x1f & color) * 255 / 31;
-    boolean w = r > 127 || g > 127 || b > 127;;
-
-    int idx = deviceHeight - 1 - my + (mx/8) * deviceHeight;
+void PixelsSSD1306::seekPixel() {
+    writePtr = frameBuffer + (mx / 8) * deviceHeight + deviceHeight - 1 - my;
+    writeMask = 1 << (mx & 7);
+}
 
-    if ( idx >= 0 && idx < deviceWidth/8 * deviceHeight ) {
-        if (w) {
-            frameBuffer[idx] |= (1 << (mx&7));
-        } else {
-            frameBuffer[idx] &= ~(1 << (mx&7));
-        }
+inline void PixelsSSD1306::deviceWriteData(uint8_t high, uint8_t low) {
+    if ( SSD1306_LIT(high << 8 | low) ) {
+        *writePtr |= writeMask;
+    } else {
+        *writePtr &= ~writeMask;
     }
 
     my++;
+    writePtr--;
     if ( my > yy2 ) {
         my = yy1;
         mx++;
         if ( mx > xx2 ) { // yy2 ?????????
             mx--;
-            return;
         }
+        seekPixel();
     }
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsSSD1306::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
@@ -236,11 +288,52 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     yy2 = bb.y2;
     mx = bb.x1;
     my = bb.y1;
+    seekPixel();
+
+    markDirty(xx1, yy1, xx2, yy2);
 
     return 1;
 }
 
-void Pixels::endGfxOperation(boolean force) {
+void PixelsSSD1306::markDirty(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    // device x selects a page (8 pixels per byte), device y a column counted from the bottom
+    int16_t p1 = x1 / 8;
+    int16_t p2 = x2 / 8;
+    int16_t c1 = deviceHeight - 1 - y2;
+    int16_t c2 = deviceHeight - 1 - y1;
+
+    if ( dirtyPage1 > dirtyPage2 ) {
+        dirtyPage1 = p1;
+        dirtyPage2 = p2;
+        dirtyColumn1 = c1;
+        dirtyColumn2 = c2;
+        return;
+    }
+
+    dirtyPage1 = min(dirtyPage1, p1);
+    dirtyPage2 = max(dirtyPage2, p2);
+    dirtyColumn1 = min(dirtyColumn1, c1);
+    dirtyColumn2 = max(dirtyColumn2, c2);
+}
+
+void PixelsSSD1306::flushColumns(int16_t column1, int16_t column2, int16_t hwColumn) {
+    writeCmd(0x21);     // COLUMNADDR
+    writeCmd(hwColumn);
+    writeCmd(hwColumn + column2 - column1);
+
+    writeCmd(0x22);     // PAGEADDR
+    writeCmd(dirtyPage1);
+    writeCmd(dirtyPage2);
+
+    for ( int p = dirtyPage1; p <= dirtyPage2; p++ ) {
+        uint8_t* ptr = frameBuffer + p * deviceHeight;
+        for ( int c = column1; c <= column2; c++ ) {
+            writeData(ptr[c]);
+        }
+    }
+}
+
+void PixelsSSD1306::endGfxOperation(boolean force) {
     gfxOpNestingDepth--;
 
 
@@ -252,46 +345,40 @@ void Pixels::endGfxOperation(boolean force) {
         gfxOpNestingDepth = 0;
     }
 
-    chipSelect();
-
-//    writeCmd(0x21);     // COLUMNADDR
-//    writeCmd(0);       // Column start address (0 = reset)
-//    writeCmd(127);       // Column end address (127 = reset)
-
-//    writeCmd(0x22); // PAGEADDR
-//    writeCmd(0);       // Page start address (0 = reset)
-//    writeCmd(deviceWidth/8 - 1);       // Page end address
-
-    if (currentScroll != 0) {
+    // a scroll moves every column of the display memory
+    if ( currentScroll != flushedScroll ) {
+        dirtyPage1 = 0;
+        dirtyPage2 = deviceWidth/8 - 1;
+        dirtyColumn1 = 0;
+        dirtyColumn2 = deviceHeight - 1;
+        flushedScroll = currentScroll;
+    }
 
-        int cs = orientation < 2 ? currentScroll : deviceHeight - currentScroll;
+    if ( dirtyPage1 > dirtyPage2 ) {
+        return;
+    }
 
-        for ( int x = 0; x < deviceWidth/8; x++ ) {
-            for ( int y = deviceHeight - cs; y < deviceHeight; y++ ) {
-                int idx  = x * deviceHeight + y;
-                if ( idx < 0 || idx >= deviceWidth/8 * deviceHeight ) {
-                    continue;
-                }
+    chipSelect();
 
-                writeData(frameBuffer[idx]);
-            }
-            for ( int y = 0; y < deviceHeight - cs; y++ ) {
-                int idx  = x * deviceHeight + y;
-                if ( idx < 0 || idx >= deviceWidth/8 * deviceHeight ) {
-                    continue;
-                }
+    // frame buffer column c is shown at display column (c + cs) % deviceHeight
+    int16_t cs = currentScroll == 0 || orientation < 2 ? currentScroll : deviceHeight - currentScroll;
+    int16_t hw = (dirtyColumn1 + cs) % deviceHeight;
+    int16_t split = dirtyColumn1 + deviceHeight - 1 - hw; // last column before the display wraps
 
-                writeData(frameBuffer[idx]);
-            }
-        }
+    if ( dirtyColumn2 > split ) {
+        flushColumns(dirtyColumn1, split, hw);
+        flushColumns(split + 1, dirtyColumn2, 0);
     } else {
-        for ( int i = 0; i < deviceWidth * deviceHeight / 8; i++ ) {
-            writeData(frameBuffer[i]);
-        }
+        flushColumns(dirtyColumn1, dirtyColumn2, hw);
     }
+
+    chipDeselect();
+
+    dirtyPage1 = 1;
+    dirtyPage2 = 0;
 }
 
-int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, prog_uint16_t* data) {
+int8_t PixelsSSD1306::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, prog_uint16_t* data) {
 
     Bounds bb(x, y, x+width-1, y+height-1);
     if( !transformBounds(bb) ) {
@@ -315,8 +402,8 @@ int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, p
         {
             for ( int16_t i = bb.x1; i <= bb.x2; i++ ) {
                 for ( int16_t j = bb.y1; j <= bb.y2; j++ ) {
-                    int16_t px = pgm_read_word_near(data + (j - y) * width + i - x);
-                    setCurrentPixel(px);
+                    uint16_t px = pgm_read_word_near(data + (j - y) * width + i - x);
+                    PixelsSSD1306::deviceWritePixels(&px, 1);
                 }
             }
         }
@@ -329,8 +416,8 @@ int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, p
             int h = bb.y2 - bb.y1 + 1;
             for ( int16_t i = 0; i < w; i++ ) {
                 for ( int16_t j = h - 1; j >= 0; j-- ) {
-                    int16_t px = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
-                    setCurrentPixel(px);
+                    uint16_t px = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
+                    PixelsSSD1306::deviceWritePixels(&px, 1);
                 }
             }
         }
@@ -343,8 +430,8 @@ int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, p
             int cutW = x < 0 ? 0 : width - w;
             for ( int16_t i = 0; i < w; i++ ) {
                 for ( int16_t j = 0; j < h; j++ ) {
-                    int16_t px = pgm_read_word_near(data + (height - j - 1 - cutH) * width + (width - i - 1 - cutW));
-                    setCurrentPixel(px);
+                    uint16_t px = pgm_read_word_near(data + (height - j - 1 - cutH) * width + (width - i - 1 - cutW));
+                    PixelsSSD1306::deviceWritePixels(&px, 1);
                 }
             }
         }
@@ -357,8 +444,8 @@ int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, p
             int h = bb.y2 - bb.y1 + 1;
             for ( int16_t i = w - 1; i >= 0; i-- ) {
                 for ( int16_t j = 0; j < h; j++ ) {
-                    int16_t px = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
-                    setCurrentPixel(px);
+                    uint16_t px = pgm_read_word_near(data + (h1 - i) * width + (w1 - j));
+                    PixelsSSD1306::deviceWritePixels(&px, 1);
                 }
             }
         }
@@ -369,7 +456,7 @@ int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, p
     return 0;
 }
 
-//boolean Pixels::checkBounds(Bounds& bb) {
+//boolean PixelsSSD1306::checkBounds(Bounds& bb) {
 //    if (bb.x2 < bb.x1) {
 //        swap(bb.x1, bb.x2);
 //    }
@@ -436,5 +523,8 @@ int8_t Pixels::drawBitmap(int16_t x, int16_t y, int16_t width, int16_t height, p
 //    return true;
 //}
 
-
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsSSD1306> Pixels;
+#endif
 #endif
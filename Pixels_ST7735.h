@@ -30,7 +30,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsST7735 : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -43,21 +43,34 @@ class Pixels : public PixelsBase
 {
 protected:
     void deviceWriteData(uint8_t high, uint8_t low);
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+    boolean setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void setFillDirection(uint8_t direction);
 
     void scrollCmd();
 
+    void setScanOrientation(uint8_t direction);
+    void setAddressWindow(Bounds bb);
+
+    /* orientation the memory access mode (MADCTL) is set for */
+    uint8_t scanOrientation;
+
 public:
-    Pixels(uint16_t width, uint16_t height) : PixelsBase(width, height) { // ElecFreaks TFT1.8SP shield pins
+    PixelsST7735(uint16_t width, uint16_t height) : PixelsBase(width, height) { // ElecFreaks TFT1.8SP shield pins
         scrollSupported = true;
         setSpiPins(6, 7, 5, 3 ,4); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels() : PixelsBase(128, 160) { // ElecFreaks TFT1.8SP shield as default
+    PixelsST7735() : PixelsBase(128, 160) { // ElecFreaks TFT1.8SP shield as default
         scrollSupported = true;
         setSpiPins(6, 7, 5, 3 ,4); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -70,7 +83,9 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsST7735::init() {
+
+    scanOrientation = PORTRAIT;
 
     initInterface();
 
@@ -178,7 +193,7 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsST7735::scrollCmd() {
     int16_t s = (orientation < 2 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
     // the feature seems to be undocumented in the datasheet
     writeCmd(0x37);
@@ -188,11 +203,11 @@ void Pixels::scrollCmd() {
     writeData(lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsST7735::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsST7735::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
         return;
@@ -200,43 +215,52 @@ void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-        writeData(hi);writeData(lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi);writeData(lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsST7735::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
         return 0;
     }
 
+    setScanOrientation(PORTRAIT);
+    setAddressWindow(bb);
+
+    return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
+}
+
+boolean PixelsST7735::setOrientedRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+
+    Bounds bb(x1, y1, x2, y2);
+    if( !checkBounds(bb) ) {
+        return false;
+    }
+
+    // in the memory access mode of the orientation column and page addresses are logical coordinates
+    untransformBounds(bb);
+    setScanOrientation(orientation);
+    setAddressWindow(bb);
+
+    return true;
+}
+
+void PixelsST7735::setScanOrientation(uint8_t direction) {
+    if ( direction == scanOrientation ) {
+        return;
+    }
+
+    // row/column exchange and mirror bits (MV, MX, MY) toggled against the portrait mode
+    static const uint8_t modeBits[] = {0x00, 0x60, 0xC0, 0xA0};
+
+    writeCmd(0x36);
+    writeData(0xC0 ^ modeBits[direction]);
+
+    scanOrientation = direction;
+}
+
+void PixelsST7735::setAddressWindow(Bounds bb) {
     writeCmd(0x2a);
     writeData(bb.x1>>8);
     writeData(bb.x1);
@@ -248,12 +272,15 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     writeData(bb.y2>>8);
     writeData(bb.y2);
     writeCmd(0x2c);
-
-    return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
 
-void Pixels::deviceWriteData(uint8_t high, uint8_t low) {
+void PixelsST7735::deviceWriteData(uint8_t high, uint8_t low) {
     writeData(high);
     writeData(low);
 }
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsST7735> Pixels;
+#endif
 #endif
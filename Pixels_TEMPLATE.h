@@ -33,7 +33,7 @@
 #define PixelsBase PixelsAntialiased
 #endif
 
-class Pixels : public PixelsBase
+class PixelsTEMPLATE : public PixelsBase
 #if defined(PIXELS_SPISW_H)
                                     , public SPIsw
 #elif defined(PIXELS_SPIHW_H)
@@ -48,6 +48,12 @@ protected:
     void deviceWriteData(uint8_t high, uint8_t low) {
         writeData(high, low);
     }
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        writePixels(data, n);
+    }
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        writeRepeat(color, n);
+    }
 
     int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
     void quickFill(int b, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
@@ -59,13 +65,13 @@ public:
 
 // 2. TODO Adjust device resolution and default pins below
 
-    Pixels() : PixelsBase(320, 480) {
+    PixelsTEMPLATE() : PixelsBase(320, 480) {
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
     }
 
-    Pixels(uint16_t width, uint16_t height) : PixelsBase( width, height) {
+    PixelsTEMPLATE(uint16_t width, uint16_t height) : PixelsBase( width, height) {
         scrollSupported = true;
         setSpiPins(4, 3, 7, 5, 6); // dummy code in PPI case
         setPpiPins(38, 39, 40, 41, 0); // dummy code in SPI case
@@ -78,7 +84,7 @@ public:
 #undef PixelsBase
 #endif
 
-void Pixels::init() {
+void PixelsTEMPLATE::init() {
 
     initInterface();
 
@@ -91,7 +97,7 @@ void Pixels::init() {
     chipDeselect();
 }
 
-void Pixels::scrollCmd() {
+void PixelsTEMPLATE::scrollCmd() {
     int16_t s = (orientation > 1 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
 //    int16_t s = (orientation < 2 ? deviceHeight - currentScroll : currentScroll) % deviceHeight;
 
@@ -103,11 +109,11 @@ void Pixels::scrollCmd() {
     //    writeData(lowByte(s));
 }
 
-void Pixels::setFillDirection(uint8_t direction) {
+void PixelsTEMPLATE::setFillDirection(uint8_t direction) {
     fillDirection = direction;
 }
 
-void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+void PixelsTEMPLATE::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     int32_t counter = setRegion(x1, y1, x2, y2);
     if( counter == 0 ) {
@@ -116,37 +122,10 @@ void Pixels::quickFill (int color, int16_t x1, int16_t y1, int16_t x2, int16_t y
 
     registerSelect();
 
-    uint8_t lo = lowByte(color);
-    uint8_t hi = highByte(color);
-
-    for (int16_t i = 0; i < counter / 20; i++) {
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-        writeData(hi, lo);
-    }
-    for (int32_t i = 0; i < counter % 20; i++) {
-        writeData(hi, lo);
-    }
+    writeRepeat(color, counter);
 }
 
-int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+int32_t PixelsTEMPLATE::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
     Bounds bb(x1, y1, x2, y2);
     if( !checkBounds(bb) ) {
         return 0;
@@ -161,4 +140,9 @@ int32_t Pixels::setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
 
     return (int32_t)(bb.x2 - bb.x1 + 1) * (bb.y2 - bb.y1 + 1);
 }
+
+#ifndef PIXELS_DEFAULT_DRIVER
+#define PIXELS_DEFAULT_DRIVER
+typedef PixelsStatic<PixelsTEMPLATE> Pixels;
+#endif
 #endif
@@ -0,0 +1,370 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * The code is written in C/C++ for Arduino and can be easily ported to any microcontroller by rewritting the low level pin access functions.
+ *
+ * Text output methods of the library rely on Pixelmeister's font data format. See: http://pd4ml.com/pixelmeister
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ *
+ * This library includes some code portions and algoritmic ideas derived from works of
+ * - Andreas Schiffler -- aschiffler at ferzkopp dot net (SDL_gfx Project)
+ * - K. Townsend http://microBuilder.eu (lpc1343codebase Project)
+ */
+
+/*
+ * Asynchronous transfers: command, data and pixel descriptors are queued and a bus backend sends them
+ * while the CPU goes on rendering. Include the file before Pixels_SPIhw.h: on AVR the hardware SPI bus
+ * then drains the queue from its transfer complete interrupt and PixelsBase::drawRasterAsync() returns
+ * without waiting. The other buses and platforms send synchronously.
+ *
+ * The interrupt costs about 200 CPU cycles per byte (entry and exit with the saved registers, the queue
+ * step and the SPDR write; an estimate from the instruction counts, not a measurement). A byte takes
+ * 8 x the clock divider cycles on the bus, so the interrupt keeps up from SPI_CLOCK_DIV32 on and leaves
+ * the CPU most of its time from SPI_CLOCK_DIV64 on. At faster clocks it would slow the transfer down:
+ * the pixels are sent synchronously there (see TRANSFER_MIN_SPI_DIVIDER).
+ *
+ * On a desktop host (see Pixels_Host.h) PixelsHostTransfer drains a queue on a worker thread into
+ * a byte sink at a simulated bus speed, so the pipelining can be tested and measured (link with -pthread)
+ */
+
+#include "Pixels.h"
+
+#if defined(PIXELS_SPIHW_H) || defined(PIXELS_SPISW_H) || defined(PIXELS_PPI8_H) || defined(PIXELS_PPI16_H)
+#error Pixels_Transfer.h must be included before Pixels_<BUS>.h
+#endif
+
+#ifndef PIXELS_TRANSFER_H
+#define PIXELS_TRANSFER_H
+
+#ifndef TRANSFER_QUEUE_SIZE
+#define TRANSFER_QUEUE_SIZE 8 // number of queued transfers (a power of two); one entry is kept free
+#endif
+
+#ifndef TRANSFER_MIN_SPI_DIVIDER
+#define TRANSFER_MIN_SPI_DIVIDER 32 // the fastest SPI clock (CPU clock / divider) sent from the interrupt
+#endif
+
+#define TRANSFER_COMMAND 0 // a command byte
+#define TRANSFER_DATA 1    // data bytes
+#define TRANSFER_PIXELS 2  // RGB565 pixels, high byte first
+#define TRANSFER_REPEAT 3  // a RGB565 pixel sent count times
+
+class PixelsTransfer {
+public:
+    uint8_t kind;
+    uint8_t value;      // TRANSFER_COMMAND byte
+    uint16_t color;     // TRANSFER_REPEAT pixel
+    const void* data;   // TRANSFER_DATA bytes or TRANSFER_PIXELS words
+    uint32_t count;     // bytes, pixels or repetitions
+    PixelsTransferDone done;
+    void* context;
+};
+
+/*
+ * Single producer, single consumer ring of transfers. The producer (drawing code) enqueues, the consumer
+ * (an interrupt handler or a worker thread) pulls the bytes to send one by one with next() and releases
+ * every sent transfer with complete(). The consumer runs the callback once it has updated its busy state,
+ * so the callback finds the bus free if nothing else is queued.
+ */
+class PixelsTransferQueue {
+private:
+    PixelsTransfer entries[TRANSFER_QUEUE_SIZE];
+    uint8_t head; // the transfer being sent; written by the consumer only
+    uint8_t tail; // the next free entry; written by the producer only
+    uint32_t sent; // bytes of the head transfer sent
+
+    boolean push(uint8_t kind, uint8_t value, uint16_t color, const void* data, uint32_t count,
+                 PixelsTransferDone done, void* context);
+
+    /* bytes of a transfer */
+    static inline uint32_t length(const PixelsTransfer& e) {
+        return e.kind == TRANSFER_COMMAND ? 1 : e.kind == TRANSFER_DATA ? e.count : e.count * 2;
+    }
+
+public:
+    PixelsTransferQueue() {
+        head = tail = 0;
+        sent = 0;
+    }
+
+    /**
+     * @return true if all the transfers are sent and released
+     */
+    inline boolean isEmpty() {
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * Queues a command byte.
+     * @return false if the queue is full
+     */
+    inline boolean enqueueCommand(uint8_t cmd, PixelsTransferDone done = NULL, void* context = NULL) {
+        return push(TRANSFER_COMMAND, cmd, 0, NULL, 1, done, context);
+    }
+    /**
+     * Queues data bytes. The buffer is not copied: it must stay unchanged until <code>done</code> is called.
+     * @return false if the queue is full
+     */
+    inline boolean enqueueData(const uint8_t* data, uint32_t n, PixelsTransferDone done = NULL, void* context = NULL) {
+        return push(TRANSFER_DATA, 0, 0, data, n, done, context);
+    }
+    /**
+     * Queues RGB565 pixels. The buffer is not copied: it must stay unchanged until <code>done</code> is called.
+     * @return false if the queue is full
+     */
+    inline boolean enqueuePixels(const uint16_t* data, uint32_t n, PixelsTransferDone done = NULL, void* context = NULL) {
+        return push(TRANSFER_PIXELS, 0, 0, data, n, done, context);
+    }
+    /**
+     * Queues a RGB565 pixel repeated <code>n</code> times.
+     * @return false if the queue is full
+     */
+    inline boolean enqueueRepeat(uint16_t color, uint32_t n, PixelsTransferDone done = NULL, void* context = NULL) {
+        return push(TRANSFER_REPEAT, 0, color, NULL, n, done, context);
+    }
+    /**
+     * Consumer side: gives the next byte of the head transfer.
+     * @param value the byte
+     * @param command true for a command byte, false for data
+     * @return false if the head transfer is sent (see complete()) or the queue is empty
+     */
+    boolean next(uint8_t& value, boolean& command);
+    /**
+     * Consumer side: releases the head transfer once all its bytes are given by next(). A transfer queued
+     * after next() found the queue empty is left alone. The callback is not run here: the consumer calls
+     * it after the release.
+     * @param done receives the callback of the transfer
+     * @param context receives the callback context
+     * @return false if there is no sent transfer
+     */
+    boolean complete(PixelsTransferDone& done, void*& context);
+};
+
+boolean PixelsTransferQueue::push(uint8_t kind, uint8_t value, uint16_t color, const void* data, uint32_t count,
+                                  PixelsTransferDone done, void* context) {
+    uint8_t t = tail;
+    uint8_t nt = (t + 1) & (TRANSFER_QUEUE_SIZE - 1);
+    if ( nt == __atomic_load_n(&head, __ATOMIC_ACQUIRE) ) {
+        return false;
+    }
+
+    PixelsTransfer& e = entries[t];
+    e.kind = kind;
+    e.value = value;
+    e.color = color;
+    e.data = data;
+    e.count = count;
+    e.done = done;
+    e.context = context;
+
+    __atomic_store_n(&tail, nt, __ATOMIC_RELEASE);
+    return true;
+}
+
+boolean PixelsTransferQueue::next(uint8_t& value, boolean& command) {
+    uint8_t h = head;
+    if ( h == __atomic_load_n(&tail, __ATOMIC_ACQUIRE) ) {
+        return false;
+    }
+
+    PixelsTransfer& e = entries[h];
+    if ( sent >= length(e) ) {
+        return false;
+    }
+
+    command = e.kind == TRANSFER_COMMAND;
+    switch ( e.kind ) {
+    case TRANSFER_COMMAND:
+        value = e.value;
+        break;
+    case TRANSFER_DATA:
+        value = ((const uint8_t*)e.data)[sent];
+        break;
+    case TRANSFER_PIXELS:
+        {
+            uint16_t c = ((const uint16_t*)e.data)[sent >> 1];
+            value = (sent & 1) ? lowByte(c) : highByte(c);
+        }
+        break;
+    default:
+        value = (sent & 1) ? lowByte(e.color) : highByte(e.color);
+        break;
+    }
+    sent++;
+    return true;
+}
+
+boolean PixelsTransferQueue::complete(PixelsTransferDone& done, void*& context) {
+    uint8_t h = head;
+    if ( h == __atomic_load_n(&tail, __ATOMIC_ACQUIRE) ) {
+        return false;
+    }
+
+    PixelsTransfer& e = entries[h];
+    if ( sent < length(e) ) {
+        return false;
+    }
+    done = e.done;
+    context = e.context;
+    sent = 0;
+    __atomic_store_n(&head, (uint8_t)((h + 1) & (TRANSFER_QUEUE_SIZE - 1)), __ATOMIC_RELEASE);
+    return true;
+}
+
+#if defined(PIXELS_HOST_H)
+
+#include <pthread.h>
+
+/*
+ * Host backend: a worker thread drains a queue into a byte sink, pacing the bytes to a bus speed.
+ * It is a bus the way the AVR interrupt is: a driver forwards its queuePixels() here and points its
+ * transfer busy flag to getBusyFlag(). The callbacks run on the worker thread
+ */
+class PixelsHostTransfer {
+private:
+    PixelsTransferQueue* queue;
+    void (*sink)(uint8_t value, boolean command, void* context);
+    void* sinkContext;
+    uint32_t bytesPerSecond;
+
+    pthread_t thread;
+    boolean started;
+    boolean running;
+
+    /* set while queued transfers are sent; the lock keeps it consistent with the queue as cli() does on AVR */
+    volatile boolean busy;
+    pthread_mutex_t lock;
+
+    static void* run(void* self);
+
+public:
+    /**
+     * @param queue the queue to drain
+     * @param bytesPerSecond simulated bus speed; 0 sends as fast as the sink takes the bytes
+     * @param sink receives every byte sent (may be NULL)
+     * @param context passed to the sink
+     */
+    PixelsHostTransfer(PixelsTransferQueue* queue, uint32_t bytesPerSecond,
+                       void (*sink)(uint8_t value, boolean command, void* context) = NULL, void* context = NULL) {
+        this->queue = queue;
+        this->bytesPerSecond = bytesPerSecond;
+        this->sink = sink;
+        sinkContext = context;
+        started = running = false;
+        busy = false;
+        pthread_mutex_init(&lock, NULL);
+    }
+
+    ~PixelsHostTransfer() {
+        stop();
+        pthread_mutex_destroy(&lock);
+    }
+
+    /**
+     * @return the flag set while queued transfers are sent, for PixelsChipSelect of the displays on the bus
+     */
+    volatile boolean* getBusyFlag() {
+        return &busy;
+    }
+
+    /**
+     * Queues RGB565 pixels and marks the bus busy. The buffer must stay unchanged until <code>done</code> is called.
+     * @return false if the queue is full
+     */
+    boolean queuePixels(const uint16_t* data, uint32_t n, PixelsTransferDone done, void* context) {
+        pthread_mutex_lock(&lock);
+        boolean queued = queue->enqueuePixels(data, n, done, context);
+        if ( queued ) {
+            busy = true;
+        }
+        pthread_mutex_unlock(&lock);
+        return queued;
+    }
+
+    /**
+     * Starts the worker thread.
+     * @return false if the thread cannot be created
+     */
+    boolean start() {
+        if ( started ) {
+            return true;
+        }
+        __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+        started = pthread_create(&thread, NULL, run, this) == 0;
+        return started;
+    }
+
+    /**
+     * Stops the worker thread once the queue is empty.
+     */
+    void stop() {
+        if ( !started ) {
+            return;
+        }
+        wait();
+        __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+        pthread_join(thread, NULL);
+        started = false;
+    }
+
+    /**
+     * Waits for the queued transfers to be sent.
+     */
+    void wait() {
+        while ( busy || !queue->isEmpty() ) {
+            usleep(10);
+        }
+    }
+};
+
+void* PixelsHostTransfer::run(void* self) {
+    PixelsHostTransfer* t = (PixelsHostTransfer*)self;
+
+    unsigned long start = micros();
+    uint64_t bytes = 0;
+    while ( __atomic_load_n(&t->running, __ATOMIC_ACQUIRE) ) {
+        if ( t->bytesPerSecond > 0 ) {
+            // a transfer completes once its bytes would have left the bus
+            uint64_t due = bytes * 1000000 / t->bytesPerSecond;
+            unsigned long elapsed = micros() - start;
+            if ( due > elapsed ) {
+                usleep(due - elapsed);
+            }
+        }
+
+        uint8_t value;
+        boolean command;
+        if ( !t->queue->next(value, command) ) {
+            PixelsTransferDone done;
+            void* context;
+            pthread_mutex_lock(&t->lock);
+            boolean sent = t->queue->complete(done, context);
+            if ( t->queue->isEmpty() ) {
+                t->busy = false;
+            }
+            pthread_mutex_unlock(&t->lock);
+            if ( sent ) {
+                // the bus is released before the callback, which may queue the next transfer
+                if ( done != NULL ) {
+                    done(context);
+                }
+                continue;
+            }
+            usleep(10);
+            start = micros();
+            bytes = 0;
+            continue;
+        }
+        if ( t->sink != NULL ) {
+            t->sink(value, command, t->sinkContext);
+        }
+        bytes++;
+    }
+    return NULL;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,149 @@
+#include <SD.h>
+#include <Pixels_PPI16.h>
+#include <Pixels_Antialiasing.h>
+#include <Pixels_ILI9325.h>
+#include <Pixels_Files.h>
+
+/*
+ * Measures throughput of Pixels primitives and prints results to the serial console.
+ * Build the sketch with and without optional Pixels features (e.g. NO_GLYPH_INDEX) to compare.
+ * The image file benchmark runs if an SD card with BENCH.BMP is found (chip select pin 53).
+ */
+
+Pixels pxs(240, 320);
+PixelsSDFile sdFile;
+
+extern prog_uchar Verdana8[637] PROGMEM;
+
+	void setup() {
+		Serial.begin(9600);
+		pxs.init();
+		pxs.setBackground(0,0,0);
+		pxs.setColor(255,255,255);
+		pxs.clear();
+
+		benchGlyphLookup();
+		benchPrint();
+		benchLines();
+		benchLoadBitmap();
+	}
+
+	void loop() {
+	}
+
+	void report(const char* name, long ops, long ms, const char* unit) {
+		Serial.print(name);
+		Serial.print(": ");
+		Serial.print(ms > 0 ? ops * 1000 / ms : ops);
+		Serial.print(" ");
+		Serial.print(unit);
+		Serial.println("/s");
+	}
+
+	void benchGlyphLookup() {
+		pxs.setFont(Verdana8);
+		String str = "Pixels Test 0123 abc";
+		long ops = 0;
+		long start = millis();
+		while ( millis() - start < 1000 ) {
+			pxs.getTextWidth(str);
+			ops += str.length();
+		}
+		report("glyph lookups", ops, millis() - start, "lookups");
+	}
+
+	void benchPrint() {
+		pxs.setFont(Verdana8);
+		String str = "Pixels Test 0123 abc";
+		for ( int mode = 0; mode < 2; mode++ ) {
+			pxs.setPrintMode(mode == 0 ? TRANSPARENT_TEXT_BACKGROUND : FILL_TEXT_BACKGROUND);
+			long ops = 0;
+			int line = 0;
+			long start = millis();
+			while ( millis() - start < 1000 ) {
+				pxs.print(5, 5 + line * 14, str);
+				line = (line + 1) % 20;
+				ops += str.length();
+			}
+			report(mode == 0 ? "print transparent" : "print fill", ops, millis() - start, "glyphs");
+		}
+		pxs.setPrintMode(TRANSPARENT_TEXT_BACKGROUND);
+	}
+
+	void benchLines() {
+		for ( int aa = 0; aa < 2; aa++ ) {
+			pxs.enableAntialiasing(aa == 1);
+			long ops = 0;
+			long start = millis();
+			while ( millis() - start < 1000 ) {
+				int i = ops % 32;
+				pxs.drawLine(10, 10 + i * 3, 230, 150 - i * 2);
+				pxs.drawLine(20 + i * 2, 160, 120 - i, 310);
+				ops += 2;
+			}
+			report(aa == 0 ? "lines" : "antialiased lines", ops, millis() - start, "lines");
+		}
+		pxs.enableAntialiasing(false);
+	}
+
+	void benchLoadBitmap() {
+		if ( !SD.begin(53) || !SD.exists("BENCH.BMP") ) {
+			Serial.println("loadBitmap: no SD card or BENCH.BMP");
+			return;
+		}
+		File f = SD.open("BENCH.BMP");
+		long size = f.size();
+		f.close();
+
+		pxs.setFileSource(&sdFile);
+		long ops = 0;
+		long start = millis();
+		while ( millis() - start < 2000 ) {
+			pxs.loadBitmap(0, 0, 0, 0, "BENCH.BMP");
+			ops += size;
+		}
+		report("loadBitmap", ops, millis() - start, "bytes");
+	}
+
+	// int[] Verdana8 = { //:Java
+	prog_uchar Verdana8[637] PROGMEM = { //:Wiring
+	0x5A,0x46,0x01,0x0C,0x0C,0x00,0x20,0x00,0x08,0x04,0x04,0x00,0x04,0x00,0x28,0x00,0x0D,0x05,0x01,0x01,
+	0x01,0xD6,0xB6,0xDB,0xB7,0x7F,0x00,0x29,0x00,0x0D,0x05,0x01,0x01,0x01,0x76,0xED,0xB6,0xB5,0xFF,0x00,
+	0x2C,0x00,0x09,0x04,0x01,0x08,0x01,0xA9,0x00,0x33,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0xBD,0x9F,0x79,
+	0xD1,0x00,0x32,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0xBD,0xDD,0xDC,0xE0,0x00,0x31,0x00,0x0D,0x07,0x01,
+	0x02,0x01,0xD8,0xF7,0xBD,0xEF,0x60,0x00,0x30,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0x9C,0xE7,0x39,0xD1,
+	0x00,0x37,0x00,0x0D,0x07,0x01,0x02,0x01,0x07,0xBB,0xDD,0xEE,0xF7,0x00,0x36,0x00,0x0D,0x07,0x01,0x02,
+	0x01,0xCD,0xDE,0x17,0x39,0xD1,0x00,0x35,0x00,0x0D,0x07,0x01,0x02,0x01,0x03,0xDE,0x1F,0x79,0xD1,0x00,
+	0x34,0x00,0x0E,0x07,0x00,0x02,0x01,0xF7,0x9D,0x6D,0x74,0x0F,0x7D,0x00,0x3A,0x00,0x09,0x05,0x02,0x04,
+	0x02,0x33,0x00,0x39,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0x9C,0xE8,0x7B,0xB3,0x00,0x38,0x00,0x0D,0x07,
+	0x01,0x02,0x01,0x8B,0x9D,0x17,0x39,0xD1,0x00,0x3D,0x00,0x0B,0x09,0x01,0x05,0x01,0x01,0xFC,0x07,0x00,
+	0x44,0x00,0x0F,0x09,0x01,0x02,0x01,0x06,0xF5,0xF3,0xE7,0xCF,0x9E,0x83,0x00,0x45,0x00,0x0D,0x07,0x01,
+	0x02,0x01,0x03,0xDE,0x07,0xBD,0xE0,0x00,0x46,0x00,0x0D,0x06,0x01,0x02,0x00,0x03,0xDE,0x17,0xBD,0xEF,
+	0x00,0x41,0x00,0x0E,0x08,0x01,0x02,0x01,0xCF,0x3B,0x6D,0xB4,0x07,0x9E,0x00,0x43,0x00,0x0F,0x09,0x01,
+	0x02,0x01,0xC3,0x79,0xFB,0xF7,0xEF,0xEF,0x61,0x00,0x4C,0x00,0x0D,0x06,0x01,0x02,0x00,0x7B,0xDE,0xF7,
+	0xBD,0xE0,0x00,0x4E,0x00,0x0E,0x08,0x01,0x02,0x01,0x38,0xE5,0x96,0x69,0xA7,0x1C,0x00,0x4F,0x00,0x0F,
+	0x09,0x01,0x02,0x01,0xC7,0x75,0xF3,0xE7,0xCF,0xAE,0xE3,0x00,0x49,0x00,0x0B,0x05,0x01,0x02,0x01,0x16,
+	0xDB,0x68,0x00,0x54,0x00,0x0F,0x07,0x00,0x02,0x00,0x01,0xDF,0xBF,0x7E,0xFD,0xFB,0xF7,0x00,0x50,0x00,
+	0x0D,0x07,0x01,0x02,0x01,0x0B,0x9C,0xE0,0xBD,0xEF,0x00,0x53,0x00,0x0E,0x08,0x01,0x02,0x01,0x85,0xE7,
+	0xE7,0xE7,0xE7,0xA1,0x00,0x52,0x00,0x0E,0x08,0x01,0x02,0x01,0x0D,0xD7,0x5D,0x0D,0xB7,0x5E,0x00,0x5F,
+	0x00,0x09,0x07,0x00,0x0B,0x00,0x01,0x00,0x66,0x00,0x0D,0x04,0x00,0x01,0x00,0xCB,0xB0,0xBB,0xBB,0xBF,
+	0x00,0x67,0x00,0x0D,0x07,0x01,0x04,0x01,0x83,0x9C,0xE7,0x43,0xD1,0x00,0x65,0x00,0x0C,0x07,0x01,0x04,
+	0x01,0x8B,0x80,0xF7,0x47,0x00,0x62,0x00,0x0E,0x07,0x01,0x01,0x01,0x7B,0xDE,0x17,0x39,0xCE,0x0F,0x00,
+	0x63,0x00,0x0C,0x06,0x01,0x04,0x00,0x8B,0x9E,0xF7,0x47,0x00,0x61,0x00,0x0C,0x07,0x01,0x04,0x01,0x8F,
+	0xA0,0xE7,0x43,0x00,0x6E,0x00,0x0C,0x07,0x01,0x04,0x01,0x0B,0x9C,0xE7,0x3B,0x00,0x6F,0x00,0x0C,0x07,
+	0x01,0x04,0x01,0x8B,0x9C,0xE7,0x47,0x00,0x6C,0x00,0x0A,0x03,0x01,0x01,0x01,0x00,0x7F,0x00,0x6D,0x00,
+	0x0F,0x0B,0x01,0x04,0x01,0x00,0xBB,0x9D,0xCE,0xE7,0x73,0xBB,0x00,0x68,0x00,0x0E,0x07,0x01,0x01,0x01,
+	0x7B,0xDE,0x17,0x39,0xCE,0x77,0x00,0x69,0x00,0x0A,0x03,0x01,0x01,0x01,0x60,0x7F,0x00,0x77,0x00,0x0E,
+	0x09,0x01,0x04,0x01,0x6C,0xD9,0x52,0xAB,0xB7,0x7F,0x00,0x76,0x00,0x0C,0x07,0x01,0x04,0x01,0x73,0xAB,
+	0x5D,0xEF,0x00,0x75,0x00,0x0C,0x07,0x01,0x04,0x01,0x73,0x9C,0xE7,0x43,0x00,0x74,0x00,0x0C,0x04,0x00,
+	0x02,0x00,0xBB,0x0B,0xBB,0xBC,0x00,0x73,0x00,0x0B,0x06,0x01,0x04,0x01,0x87,0x3C,0xE1,0x00,0x72,0x00,
+	0x0B,0x05,0x01,0x04,0x00,0x43,0x77,0x77,0x00,0x79,0x00,0x0D,0x07,0x01,0x04,0x01,0x75,0x6B,0x5D,0xEF,
+	0x77,0x00,0x78,0x00,0x0C,0x07,0x01,0x04,0x01,0x75,0x77,0xBA,0xBB,0x00,0x00,0x00,0x00,};
+	// array size:   635
+	// glyph height: 22
+	// baseline:     12
+	// range:        (), 0-9 :=ACDEFILNOPRST_abcefghilmnorstuvwxy
+	/* usage:
+		pxs.setFont(Verdana8);
+		pxs.print(x, y, "...");
+	*/
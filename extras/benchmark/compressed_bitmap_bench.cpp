@@ -0,0 +1,73 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host benchmark: decodes a compressed bitmap (raw bytes of a Pixelmeister 'Z' array or of
+ * extras/encoder -b output) into an off-screen canvas and reports the decoder throughput.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o compressed_bitmap_bench compressed_bitmap_bench.cpp ../../Pixels.cpp
+ *
+ * Usage:
+ *     compressed_bitmap_bench image.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Pixels_Canvas.h"
+
+int main(int argc, char** argv) {
+    if ( argc != 2 ) {
+        fprintf(stderr, "usage: compressed_bitmap_bench image.bin\n");
+        return 2;
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if ( f == NULL ) {
+        fprintf(stderr, "compressed_bitmap_bench: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ( (n = fread(buf, 1, sizeof(buf), f)) > 0 ) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    // image size is at bytes 8-11 of 'Z' and 4-7 of 'R' data
+    if ( data.size() < 12 || (data[0] != 'Z' && data[0] != 'R') ) {
+        fprintf(stderr, "compressed_bitmap_bench: %s is not a compressed bitmap\n", argv[1]);
+        return 1;
+    }
+    size_t header = data[0] == 'Z' ? 8 : 4;
+    int16_t width = (data[header] << 8) | data[header + 1];
+    int16_t height = (data[header + 2] << 8) | data[header + 3];
+
+    PixelsCanvas canvas(width, height);
+    canvas.init();
+    if ( canvas.drawCompressedBitmap(0, 0, &data[0]) < 0 ) {
+        fprintf(stderr, "compressed_bitmap_bench: cannot decode %s\n", argv[1]);
+        return 1;
+    }
+
+    long draws = 0;
+    unsigned long start = micros();
+    unsigned long elapsed;
+    do {
+        canvas.drawCompressedBitmap(0, 0, &data[0]);
+        draws++;
+        elapsed = micros() - start;
+    } while ( elapsed < 1000000 );
+
+    printf("%s: %c %dx%d, %u bytes, %.1f Mbit/s decoded, %.1f Mpixel/s\n", argv[1], data[0], width, height,
+            (unsigned)data.size(), data.size() * 8.0 * draws / elapsed, (double)width * height * draws / elapsed);
+    return 0;
+}
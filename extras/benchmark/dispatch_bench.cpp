@@ -0,0 +1,134 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host benchmark of the static driver composition: the same scenes are drawn on a plain PixelsCanvas,
+ * where every pixel goes through the virtual gfx operation, region and data calls, and on
+ * PixelsStatic<PixelsCanvas>, the way the Pixels typedefs compose the drivers. Both run the library code
+ * as shipped; the canvas contents must match. A single pixel takes four virtual calls on the plain
+ * canvas (gfx operation begin and end, region, data) and one composed. The time is host time, the best of
+ * several runs. It is noisy: circles and bitmaps take the same path in both, so their spread shows the
+ * noise. The call counts are what carries over to a microcontroller, where an indirect call costs the most.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o dispatch_bench dispatch_bench.cpp ../../Pixels.cpp
+ *
+ * Usage:
+ *     dispatch_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pixels_Antialiasing.h"
+#include "Pixels_Canvas.h"
+
+#define SIZE 240
+
+/* counts the single pixel writes, whether the data step is reached statically or virtually */
+class CountingCanvas : public PixelsCanvas {
+protected:
+    void deviceWriteData(uint8_t high, uint8_t low) {
+        writes++;
+        PixelsCanvas::deviceWriteData(high, low);
+    }
+public:
+    unsigned long writes;
+
+    CountingCanvas(uint16_t width, uint16_t height) : PixelsCanvas(width, height) {
+        writes = 0;
+    }
+};
+
+static uint16_t image[SIZE * SIZE];
+
+static void pixels(PixelsBase& canvas) {
+    for ( int16_t y = 0; y < SIZE; y += 2 ) {
+        for ( int16_t x = y % 4; x < SIZE; x += 4 ) {
+            canvas.drawPixel(x, y);
+        }
+    }
+}
+
+static void lines(PixelsBase& canvas) {
+    canvas.enableAntialiasing(true);
+    for ( int16_t i = 0; i < SIZE; i += 4 ) {
+        canvas.drawLine(0, i, SIZE - 1, SIZE - 1 - i);
+    }
+    canvas.enableAntialiasing(false);
+    for ( int16_t i = 0; i < SIZE; i += 4 ) {
+        canvas.drawLine(i, 0, SIZE - 1 - i, SIZE - 1);
+    }
+}
+
+static void circles(PixelsBase& canvas) {
+    for ( int16_t r = 4; r < SIZE / 2; r += 6 ) {
+        canvas.drawCircle(SIZE / 2, SIZE / 2, r);
+    }
+}
+
+static void bitmaps(PixelsBase& canvas) {
+    for ( uint8_t o = 0; o < 4; o++ ) {
+        canvas.setOrientation(o);
+        canvas.drawBitmap(0, 0, SIZE, SIZE, image);
+    }
+    canvas.setOrientation(PORTRAIT);
+}
+
+static double run(PixelsBase& canvas, void (*scene)(PixelsBase&)) {
+    double best = 0;
+    for ( uint8_t k = 0; k < 5; k++ ) {
+        long draws = 0;
+        unsigned long start = micros();
+        unsigned long elapsed;
+        do {
+            scene(canvas);
+            draws++;
+            elapsed = micros() - start;
+        } while ( elapsed < 100000 );
+        if ( k == 0 || (double)elapsed / draws < best ) {
+            best = (double)elapsed / draws;
+        }
+    }
+    return best;
+}
+
+int main() {
+    for ( int32_t i = 0; i < SIZE * SIZE; i++ ) {
+        image[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+
+    static const char* names[] = {"pixels", "lines", "circles", "bitmaps"};
+    static void (*scenes[])(PixelsBase&) = {pixels, lines, circles, bitmaps};
+
+    boolean same = true;
+    for ( uint8_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++ ) {
+        CountingCanvas plain(SIZE, SIZE);
+        PixelsStatic<CountingCanvas> composed(SIZE, SIZE);
+        PixelsBase* canvases[] = {&plain, &composed};
+        for ( uint8_t k = 0; k < 2; k++ ) {
+            canvases[k]->init();
+            canvases[k]->setBackground(0, 0, 0);
+            canvases[k]->clear();
+            canvases[k]->setColor(255, 200, 0);
+        }
+        plain.writes = composed.writes = 0;
+        scenes[i](plain);
+        scenes[i](composed);
+        boolean match = memcmp(plain.getBuffer(), composed.getBuffer(), (size_t)plain.getBufferRowBytes() * SIZE) == 0;
+        same &= match;
+
+        unsigned long writes = plain.writes;
+        double a = run(plain, scenes[i]);
+        double b = run(composed, scenes[i]);
+        printf("%-8s %6lu single pixels, virtual calls for them %6lu plain / %6lu composed, "
+                "host time %7.1f / %7.1f us (%+5.1f%%), output %s\n",
+                names[i], writes, 4 * writes, writes, a, b, (b - a) * 100 / a, match ? "matches" : "DIFFERS");
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host benchmark: streams an image file with loadBitmap() into a 320x320 off-screen canvas
+ * in every orientation and reports the throughput. Images up to 320x320 are drawn completely.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o load_bitmap_bench load_bitmap_bench.cpp ../../Pixels.cpp
+ *
+ * Usage:
+ *     load_bitmap_bench image.bmp
+ *     load_bitmap_bench image.raw width height
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "Pixels_Canvas.h"
+#include "Pixels_Files.h"
+
+int main(int argc, char** argv) {
+    if ( argc != 2 && argc != 4 ) {
+        fprintf(stderr, "usage: load_bitmap_bench image.bmp | image.raw width height\n");
+        return 2;
+    }
+    int16_t width = argc == 4 ? atoi(argv[2]) : 0;
+    int16_t height = argc == 4 ? atoi(argv[3]) : 0;
+
+    struct stat st;
+    if ( stat(argv[1], &st) != 0 ) {
+        fprintf(stderr, "load_bitmap_bench: cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    PixelsCanvas canvas(320, 320);
+    canvas.init();
+    PixelsPosixFile file;
+    canvas.setFileSource(&file);
+
+    static const char* names[] = {"portrait", "landscape", "portrait flip", "landscape flip"};
+    for ( uint8_t orientation = PORTRAIT; orientation <= LANDSCAPE_FLIP; orientation++ ) {
+        canvas.setOrientation(orientation);
+        int8_t result = canvas.loadBitmap(0, 0, width, height, argv[1]);
+        if ( result < 0 ) {
+            fprintf(stderr, "load_bitmap_bench: loadBitmap() failed with %d\n", result);
+            return 1;
+        }
+
+        long loads = 0;
+        unsigned long start = micros();
+        unsigned long elapsed;
+        do {
+            canvas.loadBitmap(0, 0, width, height, argv[1]);
+            loads++;
+            elapsed = micros() - start;
+        } while ( elapsed < 1000000 );
+
+        printf("%-15s %8.1f MB/s %8.1f images/s\n", names[orientation],
+                (double)st.st_size * loads / elapsed, loads * 1e6 / elapsed);
+    }
+    return 0;
+}
@@ -0,0 +1,383 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host check of the video memory read back: an ILI9341 on the 8bit parallel bus is emulated. The model
+ * latches a bus byte on every WR strobe, keeps the column/page window, the memory access mode (MADCTL) and
+ * the scroll start, and answers Memory Read (0x2E) with a dummy byte and the 18bit R, G, B stream of its
+ * 320x240 memory. The driver code runs as shipped.
+ *
+ * Checks:
+ * - readRegion() returns the pixels drawn, in all 4 orientations, with relative and absolute origin and
+ *   with a scroll position that makes the region wrap around the end of the video memory. Pixels clipped
+ *   by the origin and scroll are neither drawn nor read: the counts drawn and read must match;
+ * - antialiased lines, circles, round rectangles and transparent text drawn over a gradient blend with the
+ *   memory under them: every changed pixel lies between its old color and the ink color.
+ * The windows (0x2C) and memory reads (0x2E) per shape show the bus cost. Build with -DAA_SPAN_LENGTH=1 to
+ * compare the line with single step spans.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o readback_bench readback_bench.cpp ../../Pixels.cpp
+ *
+ * Usage:
+ *     readback_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pixels.h"
+
+#define OUTPUT 1
+
+// RS, WR, CS, RST, RD
+#define PIN_RS 38
+#define PIN_WR 39
+#define PIN_RD 42
+
+static regtype ports[6]; // one per bus pin, the last one for any other pin
+#define portOutputRegister(port) (&ports[port])
+#define digitalPinToPort(pin) ((pin) >= PIN_RS && (pin) <= PIN_RD ? (pin) - PIN_RS : 5)
+#define digitalPinToBitMask(pin) 1
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+#define DEVICE_WIDTH 240
+#define DEVICE_HEIGHT 320
+
+/* ILI9341 model: video memory in portrait (MADCTL 0x48) coordinates */
+static uint16_t gram[DEVICE_HEIGHT][DEVICE_WIDTH];
+static uint8_t madctl = 0x48;
+static uint16_t scrollStart = 0;
+static uint8_t command = 0;
+static uint8_t args[4];
+static uint8_t argCount = 0;
+static int16_t columnStart, columnEnd, pageStart, pageEnd;
+static int16_t column, page;
+static int16_t high = -1;
+static boolean dummy = false;
+static uint8_t component = 0;
+static unsigned long windows = 0;
+static unsigned long reads = 0;
+
+static uint16_t& cell(int16_t c, int16_t p) {
+    // page/column exchange (MV) first, then column (MX) and page (MY) mirror
+    int16_t x = c;
+    int16_t y = p;
+    if ( madctl & 0x20 ) {
+        x = p;
+        y = c;
+    }
+    if ( madctl & 0x40 ) {
+        x = DEVICE_WIDTH - 1 - x;
+    }
+    if ( madctl & 0x80 ) {
+        y = DEVICE_HEIGHT - 1 - y;
+    }
+    static uint16_t outside;
+    x = DEVICE_WIDTH - 1 - x;
+    if ( x < 0 || x >= DEVICE_WIDTH || y < 0 || y >= DEVICE_HEIGHT ) {
+        return outside;
+    }
+    return gram[y][x];
+}
+
+static void advance() {
+    if ( ++column > columnEnd ) {
+        column = columnStart;
+        if ( ++page > pageEnd ) {
+            page = pageStart;
+        }
+    }
+}
+
+static void busWrite(boolean data, uint8_t b) {
+    if ( !data ) {
+        command = b;
+        argCount = 0;
+        high = -1;
+        if ( command == 0x2c || command == 0x2e ) {
+            column = columnStart;
+            page = pageStart;
+            windows += command == 0x2c;
+            reads += command == 0x2e;
+            dummy = true;
+            component = 0;
+        }
+        return;
+    }
+    switch ( command ) {
+    case 0x36:
+        madctl = b;
+        break;
+    case 0x37:
+    case 0x2a:
+    case 0x2b:
+        if ( argCount < 4 ) {
+            args[argCount++] = b;
+        }
+        if ( command == 0x37 && argCount == 2 ) {
+            scrollStart = (args[0] << 8) | args[1];
+        } else if ( command == 0x2a && argCount == 4 ) {
+            columnStart = (args[0] << 8) | args[1];
+            columnEnd = (args[2] << 8) | args[3];
+        } else if ( command == 0x2b && argCount == 4 ) {
+            pageStart = (args[0] << 8) | args[1];
+            pageEnd = (args[2] << 8) | args[3];
+        }
+        break;
+    case 0x2c:
+        if ( high < 0 ) {
+            high = b;
+        } else {
+            cell(column, page) = (high << 8) | b;
+            high = -1;
+            advance();
+        }
+        break;
+    }
+}
+
+static uint8_t busRead() {
+    if ( command != 0x2e || dummy ) {
+        // a read without the leading dummy read gets garbage
+        dummy = false;
+        return 0x5a;
+    }
+    uint16_t p = cell(column, page);
+    uint8_t b = component == 0 ? (p >> 11) << 3 : component == 1 ? ((p >> 5) & 0x3f) << 2 : (p & 0x1f) << 3;
+    if ( ++component == 3 ) {
+        component = 0;
+        advance();
+    }
+    return b;
+}
+
+/* the data port is latched by a WR strobe; an RD strobe alone is the dummy read */
+static uint8_t PORTD;
+static uint8_t DDRD;
+
+class HostPIND {
+public:
+    operator uint8_t() const {
+        return busRead();
+    }
+};
+
+static HostPIND PIND;
+
+static void strobe(regtype* reg) {
+    if ( reg == &ports[PIN_WR - PIN_RS] ) {
+        busWrite(ports[0] & 1, PORTD);
+    } else if ( reg == &ports[PIN_RD - PIN_RS] ) {
+        dummy = false;
+    }
+}
+
+#define pulse_low(reg, bitmask) strobe(reg)
+
+#include "Pixels_PPI8.h"
+#include "Pixels_Antialiasing.h"
+#include "Pixels_ILI9341.h"
+
+extern prog_uchar Eurostile13a[494] PROGMEM;
+
+static Pixels pxs(DEVICE_WIDTH, DEVICE_HEIGHT);
+
+/* a pattern using all RGB565 bits, so a lost or shifted component shows; never black */
+static uint16_t pattern(int16_t x, int16_t y) {
+    uint16_t c = (uint16_t)(x * 7919 + y * 104729) ^ (uint16_t)(x << 5);
+    return c == 0 ? 1 : c;
+}
+
+static void resetScroll() {
+    pxs.setOrientation(PORTRAIT);
+    pxs.scroll(-pxs.getScroll(), 0);
+}
+
+static int checkReadRegion() {
+    static uint16_t out[61 * 60];
+    int fails = 0;
+    for ( int8_t scrolled = 0; scrolled < 2; scrolled++ ) {
+        for ( int8_t relative = 0; relative < 2; relative++ ) {
+            for ( uint8_t o = 0; o < 4; o++ ) {
+                resetScroll();
+                pxs.setBackground(0, 0, 0);
+                pxs.clear();
+                if ( scrolled ) {
+                    pxs.scroll(45, 0);
+                }
+                pxs.setOrientation(o);
+                if ( relative ) {
+                    pxs.setOriginRelative();
+                } else {
+                    pxs.setOriginAbsolute();
+                }
+
+                // the bottom rows: with the scroll they wrap around the end of the video memory
+                int16_t x1 = 10;
+                int16_t y1 = pxs.getHeight() - 60;
+                int16_t x2 = 70;
+                int16_t y2 = pxs.getHeight() - 1;
+                for ( int16_t y = y1; y <= y2; y++ ) {
+                    for ( int16_t x = x1; x <= x2; x++ ) {
+                        uint16_t c = pattern(x, y);
+                        pxs.setColor((c >> 11) << 3, ((c >> 5) & 0x3f) << 2, (c & 0x1f) << 3);
+                        pxs.drawPixel(x, y);
+                    }
+                }
+
+                for ( int16_t i = 0; i < 61 * 60; i++ ) {
+                    out[i] = 0x1234;
+                }
+                boolean read = pxs.readRegion(x1, y1, x2, y2, out);
+                int16_t drawn = 0;
+                for ( int16_t y = 0; y < DEVICE_HEIGHT; y++ ) {
+                    for ( int16_t x = 0; x < DEVICE_WIDTH; x++ ) {
+                        drawn += gram[y][x] != 0;
+                    }
+                }
+                int16_t bad = 0;
+                int16_t unread = 0;
+                for ( int16_t y = y1; y <= y2; y++ ) {
+                    for ( int16_t x = x1; x <= x2; x++ ) {
+                        uint16_t c = out[(y - y1) * 61 + x - x1];
+                        if ( c == 0x1234 ) {
+                            unread++;
+                        } else if ( c != pattern(x, y) ) {
+                            bad++;
+                        }
+                    }
+                }
+                printf("readRegion scroll %3d %-8s orientation %d: %4d drawn, %4d read, %4d clipped, %d bad\n",
+                       pxs.getScroll(), relative ? "relative" : "absolute", o, drawn, 61 * 60 - unread, unread, bad);
+                fails += bad != 0 || drawn != 61 * 60 - unread || read != (drawn > 0);
+            }
+        }
+    }
+    return fails;
+}
+
+static uint16_t snapshot[DEVICE_HEIGHT][DEVICE_WIDTH];
+
+static boolean between(uint8_t v, uint8_t a, uint8_t b) {
+    // one step of rounding either way
+    return v + 1 >= min(a, b) && v <= max(a, b) + 1;
+}
+
+/* every pixel changed since the snapshot must lie between its old color and the ink */
+static int checkBlend(const char* name, uint16_t ink) {
+    int changed = 0;
+    int outside = 0;
+    for ( int16_t y = 0; y < DEVICE_HEIGHT; y++ ) {
+        for ( int16_t x = 0; x < DEVICE_WIDTH; x++ ) {
+            uint16_t a = snapshot[y][x];
+            uint16_t b = gram[y][x];
+            if ( a == b ) {
+                continue;
+            }
+            changed++;
+            if ( !between(b >> 11, a >> 11, ink >> 11) ||
+                 !between((b >> 5) & 0x3f, (a >> 5) & 0x3f, (ink >> 5) & 0x3f) ||
+                 !between(b & 0x1f, a & 0x1f, ink & 0x1f) ) {
+                outside++;
+            }
+        }
+    }
+    printf("%-20s %5d pixels changed, %d not between background and ink\n", name, changed, outside);
+    return outside != 0 || changed == 0;
+}
+
+static void gradient() {
+    resetScroll();
+    pxs.setOriginAbsolute();
+    pxs.enableAntialiasing(false);
+    for ( int16_t y = 0; y < pxs.getHeight(); y++ ) {
+        pxs.setColor(y * 3 % 256, 255 - y % 200, y * 7 % 256);
+        pxs.drawLine(0, y, pxs.getWidth() - 1, y);
+    }
+    pxs.enableAntialiasing(true);
+    pxs.setColor(250, 250, 0);
+    memcpy(snapshot, gram, sizeof(gram));
+    windows = reads = 0;
+}
+
+static void cost(const char* name) {
+    printf("%-20s %5lu windows, %lu memory reads\n", name, windows, reads);
+}
+
+static int checkBlending() {
+    int fails = 0;
+    uint16_t ink = (250 >> 3) << 11 | (250 >> 2) << 5;
+
+    gradient();
+    pxs.drawLine(5, 10, 200, 80);
+    cost("line");
+    fails += checkBlend("line", ink);
+
+    gradient();
+    pxs.drawCircle(120, 160, 50);
+    cost("circle");
+    fails += checkBlend("circle", ink);
+
+    gradient();
+    pxs.drawRoundRectangle(20, 100, 180, 60, 12);
+    cost("round rectangle");
+    fails += checkBlend("round rectangle", ink);
+
+    gradient();
+    pxs.setFont(Eurostile13a);
+    pxs.print(30, 260, "Pixels");
+    cost("transparent text");
+    fails += checkBlend("transparent text", ink);
+
+    return fails;
+}
+
+int main() {
+    pxs.setPpiPins(PIN_RS, PIN_WR, 40, 41, PIN_RD);
+    pxs.init();
+
+    int fails = checkReadRegion();
+    fails += checkBlending();
+
+    printf(fails == 0 ? "OK\n" : "FAILED\n");
+    return fails == 0 ? 0 : 1;
+}
+
+// int[] Eurostile13a = { //:Java
+prog_uchar Eurostile13a[494] PROGMEM = { //:Wiring
+0x5A,0x46,0x02,0x0F,0x0F,0x00,0x54,0x00,0x34,0x09,0x80,0x01,0x01,0x03,0x30,0x4B,0x81,0x2F,0x4B,0x81,
+0x2F,0x4B,0x81,0x2E,0x3E,0x3E,0x3E,0x3E,0x3E,0x3E,0x3E,0x3E,0x3E,0x3E,0x3E,0x8E,0x20,0x2B,0x2B,0x2B,
+0x2B,0x2B,0x2B,0x2B,0x2B,0x2B,0x2B,0x2B,0x81,0x2F,0x4B,0x81,0x2F,0x4B,0x81,0x2F,0x4B,0x00,0x20,0x00,
+0x08,0x05,0x05,0x00,0x05,0x00,0x74,0x00,0x3D,0x06,0x80,0x02,0x00,0x43,0x08,0x31,0x48,0x26,0x04,0x04,
+0x00,0x03,0x04,0x04,0x04,0x04,0x04,0x10,0x2E,0x41,0x37,0x2C,0x2C,0x05,0x22,0x2C,0x2C,0x2C,0x2C,0x2B,
+0x1A,0x0A,0x44,0x08,0x31,0x45,0x3E,0x02,0x3C,0x43,0x08,0x31,0x43,0x3E,0x2C,0x1B,0x0E,0x44,0x22,0x38,
+0x43,0x3C,0x0A,0x1A,0x34,0x41,0x00,0x65,0x00,0x52,0x09,0x00,0x05,0x00,0x41,0x39,0x16,0x07,0x01,0x07,
+0x13,0x35,0x42,0x15,0x0F,0x31,0x38,0x33,0x14,0x0E,0x41,0x3F,0x01,0x2D,0x43,0x34,0x81,0x3D,0x3A,0x81,
+0x2C,0x36,0x36,0x36,0x31,0x81,0x37,0x36,0x81,0x07,0x08,0x08,0x08,0x08,0x08,0x35,0x3A,0x81,0x34,0x46,
+0x3E,0x00,0x2F,0x43,0x3B,0x19,0x39,0x41,0x0F,0x16,0x3D,0x42,0x24,0x00,0x3C,0x41,0x33,0x0D,0x01,0x05,
+0x03,0x05,0x25,0x44,0x3F,0x39,0x3C,0x43,0x00,0x73,0x00,0x4C,0x09,0x00,0x05,0x01,0x41,0x26,0x0A,0x03,
+0x01,0x08,0x1D,0x3E,0x3A,0x00,0x1F,0x37,0x39,0x33,0x04,0x24,0x33,0x81,0x36,0x43,0x2A,0x2D,0x3B,0x00,
+0x1D,0x3B,0x3F,0x44,0x26,0x08,0x81,0x00,0x05,0x1C,0x3A,0x43,0x3D,0x3A,0x32,0x0B,0x20,0x32,0x11,0x3F,
+0x43,0x1D,0x0E,0x34,0x81,0x2B,0x42,0x3C,0x0B,0x13,0x41,0x1D,0x03,0x04,0x05,0x00,0x0C,0x34,0x42,0x3F,
+0x3B,0x39,0x3D,0x42,0x00,0x50,0x00,0x54,0x0B,0x01,0x01,0x00,0x09,0x84,0x00,0x06,0x13,0x36,0x41,0x09,
+0x1B,0x36,0x36,0x36,0x36,0x30,0x10,0x11,0x41,0x09,0x20,0x45,0x2D,0x00,0x3F,0x09,0x20,0x45,0x33,0x81,
+0x3A,0x09,0x20,0x45,0x34,0x81,0x38,0x09,0x20,0x45,0x2C,0x00,0x3E,0x09,0x1B,0x35,0x35,0x35,0x32,0x2A,
+0x0B,0x10,0x41,0x09,0x85,0x03,0x12,0x36,0x41,0x09,0x1E,0x3C,0x3C,0x3C,0x3D,0x44,0x09,0x20,0x48,0x09,
+0x20,0x48,0x09,0x20,0x48,0x09,0x20,0x48,0x00,0x6C,0x00,0x22,0x03,0x01,0x01,0x00,0x05,0x2C,0x05,0x2C,
+0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,
+0x05,0x2C,0x00,0x78,0x00,0x39,0x07,0x80,0x05,0x01,0x25,0x3E,0x45,0x38,0x11,0x0C,0x09,0x30,0x43,0x26,
+0x03,0x11,0x3C,0x1E,0x02,0x19,0x34,0x11,0x05,0x28,0x43,0x36,0x06,0x81,0x0A,0x3A,0x43,0x2F,0x0B,0x0B,
+0x22,0x04,0x11,0x37,0x41,0x18,0x02,0x21,0x3E,0x41,0x39,0x14,0x02,0x22,0x17,0x36,0x45,0x2A,0x05,0x00,
+0x69,0x00,0x1F,0x03,0x01,0x01,0x00,0x05,0x2C,0x29,0x38,0x44,0x0C,0x2E,0x05,0x2C,0x05,0x2C,0x05,0x2C,
+0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x05,0x2C,0x00,0x00,0x00,0x00,};
@@ -0,0 +1,212 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host check of the 9-bit hardware SPI packing: the AVR SPI registers are emulated and every bit clocked
+ * out is recorded, a D/C bit when SPI is enabled again after the bit-bang and eight bits per SPDR write.
+ * Pixel bursts sent packed by writePixels() and writeRepeat() must give the same bitstream as the
+ * byte by byte writeData() reference. The register write counts show the cost saved per pixel.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o spi9_bench spi9_bench.cpp ../../Pixels.cpp
+ *
+ * Usage:
+ *     spi9_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pixels.h"
+
+#define _BV(bit) (1 << (bit))
+#define SPIF 7
+#define SPE 6
+#define DORD 5
+#define MSTR 4
+#define B00000001 1
+
+#define LOW 0
+#define HIGH 1
+#define OUTPUT 1
+#define LSBFIRST 0
+
+#define PIN_SCL 13
+#define PIN_SDA 11
+
+#define MAX_BITS 100000
+
+static uint8_t bits[MAX_BITS];
+static int32_t bitCount = 0;
+static boolean recording = false;
+static unsigned long spcrWrites = 0;
+static unsigned long spdrWrites = 0;
+
+static void record(uint8_t bit) {
+    if ( !recording ) {
+        return;
+    }
+    if ( bitCount < MAX_BITS ) {
+        bits[bitCount] = bit;
+    }
+    bitCount++;
+}
+
+static regtype ports[3]; // SCL, SDA, other pins
+#define portOutputRegister(port) (&ports[port])
+#define digitalPinToPort(pin) ((pin) == PIN_SCL ? 0 : (pin) == PIN_SDA ? 1 : 2)
+#define digitalPinToBitMask(pin) 1
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+static uint8_t DDRB, PORTB;
+static uint8_t SPSR = _BV(SPIF); // transfers complete at once
+
+/* the bit-banged D/C bit is clocked with SDA as it is when SPI gets enabled again */
+class HostSPCR {
+private:
+    uint8_t value;
+    void write(uint8_t v) {
+        spcrWrites++;
+        if ( !(value & _BV(SPE)) && (v & _BV(SPE)) ) {
+            record(ports[1] & 1);
+        }
+        value = v;
+    }
+public:
+    HostSPCR() {
+        value = 0;
+    }
+    operator uint8_t() const {
+        return value;
+    }
+    HostSPCR& operator=(uint8_t v) {
+        write(v);
+        return *this;
+    }
+    HostSPCR& operator|=(uint8_t v) {
+        write(value | v);
+        return *this;
+    }
+    HostSPCR& operator&=(uint8_t v) {
+        write(value & v);
+        return *this;
+    }
+};
+
+class HostSPDR {
+public:
+    HostSPDR& operator=(uint8_t v) {
+        spdrWrites++;
+        for ( int8_t i = 7; i >= 0; i-- ) {
+            record((v >> i) & 1);
+        }
+        return *this;
+    }
+};
+
+static HostSPCR SPCR;
+static HostSPDR SPDR;
+
+#include "Pixels_SPIhw.h"
+
+class HostBus : public SPIhw {
+public:
+    void reference(uint8_t cmd, const uint16_t* data, uint32_t n) {
+        writeCmd(cmd);
+        while ( n-- > 0 ) {
+            writeData(highByte(*data));
+            writeData(lowByte(*data));
+            data++;
+        }
+    }
+    void pixels(uint8_t cmd, const uint16_t* data, uint32_t n) {
+        writeCmd(cmd);
+        writePixels(data, n);
+    }
+    void repeat(uint8_t cmd, uint16_t color, uint32_t n) {
+        writeCmd(cmd);
+        writeRepeat(color, n);
+    }
+};
+
+static HostBus bus;
+
+static uint8_t expected[MAX_BITS];
+static int32_t expectedCount;
+static unsigned long referenceSpcr;
+static unsigned long referenceSpdr;
+
+static void start() {
+    recording = true;
+    bitCount = 0;
+    spcrWrites = spdrWrites = 0;
+}
+
+static void keep() {
+    memcpy(expected, bits, sizeof(bits));
+    expectedCount = bitCount;
+    referenceSpcr = spcrWrites;
+    referenceSpdr = spdrWrites;
+}
+
+static boolean check(const char* name, uint32_t n, uint32_t pixels) {
+    boolean same = bitCount == expectedCount && bitCount <= MAX_BITS && memcmp(bits, expected, bitCount) == 0;
+    printf("%-8s %4u pixels: %6d bits, per pixel SPCR writes %5.2f / %5.2f, SPDR writes %5.2f / %5.2f, bitstreams %s\n",
+            name, n, bitCount,
+            (double)referenceSpcr / pixels, (double)spcrWrites / pixels,
+            (double)referenceSpdr / pixels, (double)spdrWrites / pixels,
+            same ? "match" : "DIFFER");
+    return same;
+}
+
+int main() {
+    bus.setSpiPins(PIN_SCL, PIN_SDA, 10, 8);
+    bus.initInterface();
+
+    static uint16_t data[1024];
+    for ( int16_t i = 0; i < 1024; i++ ) {
+        data[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+
+    boolean ok = true;
+    // the counts cover whole packed groups and the remainders sent byte by byte
+    static const uint32_t counts[] = {1, 3, 4, 7, 64, 1021};
+    for ( uint8_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++ ) {
+        uint32_t n = counts[i];
+
+        start();
+        bus.reference(0x2c, data, n);
+        bus.reference(0x2c, data + 1, n);
+        keep();
+        start();
+        bus.pixels(0x2c, data, n);
+        bus.pixels(0x2c, data + 1, n);
+        ok &= check("pixels", n, n * 2);
+
+        start();
+        for ( uint32_t k = 0; k < n; k++ ) {
+            data[1023 - k] = 0xf81f;
+        }
+        bus.reference(0x2c, data + 1024 - n, n);
+        keep();
+        start();
+        bus.repeat(0x2c, 0xf81f, n);
+        ok &= check("repeat", n, n);
+        for ( uint32_t k = 0; k < n; k++ ) {
+            data[1023 - k] = (uint16_t)((1023 - k) * 2654435761u >> 16);
+        }
+    }
+
+    printf("%s\n", ok ? "all bitstreams match" : "bitstream mismatch");
+    return ok ? 0 : 1;
+}
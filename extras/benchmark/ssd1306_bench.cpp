@@ -0,0 +1,448 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host benchmark of the SSD1306 frame buffer and its flush: the driver as shipped runs next to Previous,
+ * a subclass that restores the former frame buffer writes (a colour test with three divisions and one bit
+ * set per pixel, with a bounds check and an index multiply each) and the former flush of the whole frame
+ * buffer after every graphics operation. Each driver sends its bytes to a model of the SSD1306 display
+ * memory in horizontal addressing mode, which keeps the column and page address window. The same steps
+ * are drawn on both in all 4 orientations, with and without scroll; after every step the frame buffers
+ * and the display memories must match. The bytes sent per step (commands and data) show the flush cost.
+ * clear() and fillRectangle() are timed with the display flush held off, so only the frame buffer work is
+ * measured. The time is host time, the best of several runs.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o ssd1306_bench ssd1306_bench.cpp ../../Pixels.cpp
+ *
+ * Usage:
+ *     ssd1306_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pixels.h"
+
+#define _BV(bit) (1 << (bit))
+#define SPIF 7
+#define SPE 6
+#define DORD 5
+#define MSTR 4
+#define B00000001 1
+
+#define LOW 0
+#define HIGH 1
+#define OUTPUT 1
+#define LSBFIRST 0
+
+#define PIN_DC 2
+
+static regtype ports[16];
+#define portOutputRegister(port) (&ports[port])
+#define digitalPinToPort(pin) ((pin) & 15)
+#define digitalPinToBitMask(pin) 1
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+static uint8_t SPCR, DDRB, PORTB;
+static uint8_t SPSR = _BV(SPIF); // transfers complete at once
+
+#define PAGES 8
+#define COLUMNS 128
+
+/* SSD1306 display memory in horizontal addressing mode; commands and their arguments are sent with D/C low */
+class Display {
+private:
+    uint8_t command;
+    uint8_t args[2];
+    uint8_t argCount;
+    uint8_t columnStart, columnEnd, pageStart, pageEnd;
+    uint8_t column, page;
+
+    /* number of argument bytes following a command */
+    static uint8_t arguments(uint8_t cmd) {
+        switch ( cmd ) {
+        case 0x21: // COLUMNADDR
+        case 0x22: // PAGEADDR
+            return 2;
+        case 0x20: // MEMORYMODE
+        case 0x81: // SETCONTRAST
+        case 0x8D: // CHARGEPUMP
+        case 0xA8: // SETMULTIPLEX
+        case 0xD3: // SETDISPLAYOFFSET
+        case 0xD5: // SETDISPLAYCLOCKDIV
+        case 0xD9: // SETPRECHARGE
+        case 0xDA: // SETCOMPINS
+        case 0xDB: // SETVCOMDETECT
+            return 1;
+        }
+        return 0;
+    }
+
+public:
+    uint8_t memory[PAGES][COLUMNS];
+    unsigned long bytes;
+
+    Display() {
+        memset(memory, 0, sizeof(memory));
+        command = 0;
+        argCount = 0;
+        columnStart = column = 0;
+        columnEnd = COLUMNS - 1;
+        pageStart = page = 0;
+        pageEnd = PAGES - 1;
+        bytes = 0;
+    }
+
+    void write(boolean data, uint8_t b) {
+        bytes++;
+        if ( !data ) {
+            if ( argCount < arguments(command) ) {
+                args[argCount++] = b;
+                if ( argCount == 2 && command == 0x21 ) {
+                    columnStart = column = args[0];
+                    columnEnd = args[1];
+                } else if ( argCount == 2 && command == 0x22 ) {
+                    pageStart = page = args[0];
+                    pageEnd = args[1];
+                }
+            } else {
+                command = b;
+                argCount = 0;
+            }
+            return;
+        }
+        if ( page < PAGES && column < COLUMNS ) {
+            memory[page][column] = b;
+        }
+        if ( ++column > columnEnd ) {
+            column = columnStart;
+            if ( ++page > pageEnd ) {
+                page = pageStart;
+            }
+        }
+    }
+};
+
+static Display* display;
+
+class HostSPDR {
+public:
+    HostSPDR& operator=(uint8_t v) {
+        display->write(ports[PIN_DC] & 1, v);
+        return *this;
+    }
+};
+
+static HostSPDR SPDR;
+
+#include "Pixels_SPIhw.h"
+#include "Pixels_SSD1306.h"
+
+#define WIDTH 64
+#define HEIGHT 128
+#define BUFFER_SIZE (WIDTH / 8 * HEIGHT)
+
+extern prog_uchar Verdana8[637] PROGMEM;
+
+/* the driver as shipped; hold() keeps a graphics operation open, so nothing is flushed until release() */
+class Shipped : public PixelsSSD1306 {
+public:
+    Shipped() : PixelsSSD1306(WIDTH, HEIGHT) {
+    }
+
+    void hold() {
+        beginGfxOperation();
+    }
+
+    void release() {
+        endGfxOperation(false);
+    }
+
+    const uint8_t* getFrameBuffer() {
+        return frameBuffer;
+    }
+};
+
+/* the frame buffer writes and the flush the driver had before */
+class Previous : public Shipped {
+protected:
+    void quickFill(int color, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+        uint8_t r = ((0xf800 & color) >> 11) * 255 / 31;
+        uint8_t g = ((0x7e0 & color) >> 5) * 255 / 63;
+        uint8_t b = (0x1f & color) * 255 / 31;
+        boolean w = r > 127 || g > 127 || b > 127;
+
+        if ( !setRegion(x1, y1, x2, y2) ) {
+            return;
+        }
+
+        for ( int y = yy1; y <= yy2; y++ ) {
+            for ( int x = xx1; x <= xx2; x++ ) {
+                int idx = deviceHeight - y - 1 + (x / 8) * deviceHeight;
+                if ( idx < 0 || idx >= deviceWidth / 8 * deviceHeight ) {
+                    continue;
+                }
+                if ( w ) {
+                    frameBuffer[idx] |= (1 << (x & 7));
+                } else {
+                    frameBuffer[idx] &= ~(1 << (x & 7));
+                }
+            }
+        }
+    }
+
+    void deviceWriteData(uint8_t high, uint8_t low) {
+        int color = (((uint16_t)high) << 8) + low;
+        uint8_t r = ((0xf800 & color) >> 11) * 255 / 31;
+        uint8_t g = ((0x7e0 & color) >> 5) * 255 / 63;
+        uint8_t b = (0x1f & color) * 255 / 31;
+        boolean w = r > 127 || g > 127 || b > 127;
+
+        int idx = deviceHeight - 1 - my + (mx / 8) * deviceHeight;
+        if ( idx >= 0 && idx < deviceWidth / 8 * deviceHeight ) {
+            if ( w ) {
+                frameBuffer[idx] |= (1 << (mx & 7));
+            } else {
+                frameBuffer[idx] &= ~(1 << (mx & 7));
+            }
+        }
+
+        my++;
+        if ( my > yy2 ) {
+            my = yy1;
+            mx++;
+            if ( mx > xx2 ) {
+                mx--;
+            }
+        }
+    }
+
+    /* the shipped burst writes call the shipped deviceWriteData() statically */
+    void deviceWritePixels(const uint16_t* data, uint32_t n) {
+        while ( n-- > 0 ) {
+            deviceWriteData(highByte(*data), lowByte(*data));
+            data++;
+        }
+    }
+
+    void deviceWriteRepeat(uint16_t color, uint32_t n) {
+        while ( n-- > 0 ) {
+            deviceWriteData(highByte(color), lowByte(color));
+        }
+    }
+
+    /* the whole frame buffer after every graphics operation, through the window init() sets */
+    void endGfxOperation(boolean force) {
+        gfxOpNestingDepth--;
+        if ( !force ) {
+            if ( gfxOpNestingDepth > 0 ) {
+                return;
+            }
+            gfxOpNestingDepth = 0;
+        }
+
+        chipSelect();
+        if ( currentScroll != 0 ) {
+            int cs = orientation < 2 ? currentScroll : deviceHeight - currentScroll;
+            for ( int x = 0; x < deviceWidth / 8; x++ ) {
+                for ( int y = deviceHeight - cs; y < deviceHeight; y++ ) {
+                    writeData(frameBuffer[x * deviceHeight + y]);
+                }
+                for ( int y = 0; y < deviceHeight - cs; y++ ) {
+                    writeData(frameBuffer[x * deviceHeight + y]);
+                }
+            }
+        } else {
+            for ( int i = 0; i < deviceWidth * deviceHeight / 8; i++ ) {
+                writeData(frameBuffer[i]);
+            }
+        }
+        chipDeselect();
+    }
+};
+
+static const char* steps[] = {"clear", "pixel", "line", "digit", "rectangle", "565 colors", "text background",
+                              "circle", "scroll", "scrolled pixel", "wrapped circle", "scroll back"};
+
+static void step(PixelsBase& d, uint8_t i) {
+    switch ( i ) {
+    case 0:
+        d.clear();
+        break;
+    case 1:
+        d.drawPixel(10, 20);
+        break;
+    case 2:
+        d.drawLine(0, 0, 40, 60);
+        break;
+    case 3:
+        d.print(20, 30, "7");
+        break;
+    case 4:
+        d.fillRectangle(30, 5, 20, 10);
+        break;
+    case 5:
+        // blue above and grey below the half of the range: one lit and one dark
+        d.setColor565(RGB565(0, 0, 200));
+        d.fillRectangle(3, 44, 21, 13);
+        d.setColor565(RGB565(20, 20, 20));
+        d.fillRectangle(5, 46, 7, 5);
+        d.setColor(255, 255, 255);
+        break;
+    case 6:
+        d.setPrintMode(FILL_TEXT_BACKGROUND);
+        d.setBackground(255, 255, 255);
+        d.setColor(0, 0, 0);
+        d.print(3, 50, "5x");
+        d.setPrintMode(0);
+        d.setBackground(0, 0, 0);
+        d.setColor(255, 255, 255);
+        break;
+    case 7:
+        d.drawCircle(30, 40, 25);
+        break;
+    case 8:
+        d.scroll(13, 0);
+        break;
+    case 9:
+        // absolute coordinates near the far edges: the scroll moves them past the end of the display memory
+        d.setOriginAbsolute();
+        d.drawPixel(d.getWidth() - 3, d.getHeight() - 3);
+        d.setOriginRelative();
+        break;
+    case 10:
+        // across the wrap, flushed in two windows
+        d.setOriginAbsolute();
+        d.drawCircle(d.getWidth() - 8, d.getHeight() - 8, 6);
+        d.setOriginRelative();
+        break;
+    case 11:
+        d.scroll(-13, 0);
+        break;
+    }
+}
+
+static void clearScene(Shipped& d) {
+    static uint8_t i = 0;
+    d.setBackground(i++ & 1 ? 255 : 0, 0, 0);
+    d.clear();
+}
+
+static void fillScene(Shipped& d) {
+    static uint8_t i = 0;
+    d.setColor(i++ & 1 ? 255 : 0, 0, 0);
+    d.fillRectangle(3, 5, 57, 100);
+}
+
+static double run(Shipped& d, void (*scene)(Shipped&)) {
+    double best = 0;
+    d.hold();
+    for ( uint8_t k = 0; k < 5; k++ ) {
+        long draws = 0;
+        unsigned long start = micros();
+        unsigned long elapsed;
+        do {
+            scene(d);
+            draws++;
+            elapsed = micros() - start;
+        } while ( elapsed < 100000 );
+        if ( k == 0 || (double)elapsed / draws < best ) {
+            best = (double)elapsed / draws;
+        }
+    }
+    d.release();
+    return best;
+}
+
+int main() {
+    Previous previous;
+    Shipped shipped;
+    Shipped* drivers[] = {&previous, &shipped};
+    static Display displays[2];
+
+    for ( uint8_t k = 0; k < 2; k++ ) {
+        display = &displays[k];
+        drivers[k]->init();
+        drivers[k]->setBackground(0, 0, 0);
+        drivers[k]->setColor(255, 255, 255);
+        drivers[k]->setFont(Verdana8);
+    }
+
+    int fails = 0;
+    for ( uint8_t o = 0; o < 4; o++ ) {
+        for ( uint8_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++ ) {
+            unsigned long bytes[2];
+            for ( uint8_t k = 0; k < 2; k++ ) {
+                display = &displays[k];
+                drivers[k]->setOrientation(o);
+                unsigned long sent = display->bytes;
+                step(*drivers[k], i);
+                bytes[k] = display->bytes - sent;
+            }
+            boolean match = memcmp(previous.getFrameBuffer(), shipped.getFrameBuffer(), BUFFER_SIZE) == 0;
+            boolean shown = memcmp(displays[0].memory, displays[1].memory, sizeof(displays[0].memory)) == 0;
+            printf("orientation %d %-16s bytes %5lu previous / %5lu shipped, frame buffer %s, display memory %s\n",
+                   o, steps[i], bytes[0], bytes[1], match ? "matches" : "DIFFERS", shown ? "matches" : "DIFFERS");
+            fails += !match || !shown;
+        }
+    }
+
+    static const char* names[] = {"clear()", "fillRectangle(3, 5, 57, 100)"};
+    static void (*scenes[])(Shipped&) = {clearScene, fillScene};
+    for ( uint8_t i = 0; i < 2; i++ ) {
+        display = &displays[0];
+        double a = run(previous, scenes[i]);
+        display = &displays[1];
+        double b = run(shipped, scenes[i]);
+        printf("%-30s host time %8.2f us previous / %8.2f us shipped\n", names[i], a, b);
+    }
+
+    printf(fails == 0 ? "OK\n" : "FAILED\n");
+    return fails == 0 ? 0 : 1;
+}
+
+// int[] Verdana8 = { //:Java
+prog_uchar Verdana8[637] PROGMEM = { //:Wiring
+0x5A,0x46,0x01,0x0C,0x0C,0x00,0x20,0x00,0x08,0x04,0x04,0x00,0x04,0x00,0x28,0x00,0x0D,0x05,0x01,0x01,
+0x01,0xD6,0xB6,0xDB,0xB7,0x7F,0x00,0x29,0x00,0x0D,0x05,0x01,0x01,0x01,0x76,0xED,0xB6,0xB5,0xFF,0x00,
+0x2C,0x00,0x09,0x04,0x01,0x08,0x01,0xA9,0x00,0x33,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0xBD,0x9F,0x79,
+0xD1,0x00,0x32,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0xBD,0xDD,0xDC,0xE0,0x00,0x31,0x00,0x0D,0x07,0x01,
+0x02,0x01,0xD8,0xF7,0xBD,0xEF,0x60,0x00,0x30,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0x9C,0xE7,0x39,0xD1,
+0x00,0x37,0x00,0x0D,0x07,0x01,0x02,0x01,0x07,0xBB,0xDD,0xEE,0xF7,0x00,0x36,0x00,0x0D,0x07,0x01,0x02,
+0x01,0xCD,0xDE,0x17,0x39,0xD1,0x00,0x35,0x00,0x0D,0x07,0x01,0x02,0x01,0x03,0xDE,0x1F,0x79,0xD1,0x00,
+0x34,0x00,0x0E,0x07,0x00,0x02,0x01,0xF7,0x9D,0x6D,0x74,0x0F,0x7D,0x00,0x3A,0x00,0x09,0x05,0x02,0x04,
+0x02,0x33,0x00,0x39,0x00,0x0D,0x07,0x01,0x02,0x01,0x8B,0x9C,0xE8,0x7B,0xB3,0x00,0x38,0x00,0x0D,0x07,
+0x01,0x02,0x01,0x8B,0x9D,0x17,0x39,0xD1,0x00,0x3D,0x00,0x0B,0x09,0x01,0x05,0x01,0x01,0xFC,0x07,0x00,
+0x44,0x00,0x0F,0x09,0x01,0x02,0x01,0x06,0xF5,0xF3,0xE7,0xCF,0x9E,0x83,0x00,0x45,0x00,0x0D,0x07,0x01,
+0x02,0x01,0x03,0xDE,0x07,0xBD,0xE0,0x00,0x46,0x00,0x0D,0x06,0x01,0x02,0x00,0x03,0xDE,0x17,0xBD,0xEF,
+0x00,0x41,0x00,0x0E,0x08,0x01,0x02,0x01,0xCF,0x3B,0x6D,0xB4,0x07,0x9E,0x00,0x43,0x00,0x0F,0x09,0x01,
+0x02,0x01,0xC3,0x79,0xFB,0xF7,0xEF,0xEF,0x61,0x00,0x4C,0x00,0x0D,0x06,0x01,0x02,0x00,0x7B,0xDE,0xF7,
+0xBD,0xE0,0x00,0x4E,0x00,0x0E,0x08,0x01,0x02,0x01,0x38,0xE5,0x96,0x69,0xA7,0x1C,0x00,0x4F,0x00,0x0F,
+0x09,0x01,0x02,0x01,0xC7,0x75,0xF3,0xE7,0xCF,0xAE,0xE3,0x00,0x49,0x00,0x0B,0x05,0x01,0x02,0x01,0x16,
+0xDB,0x68,0x00,0x54,0x00,0x0F,0x07,0x00,0x02,0x00,0x01,0xDF,0xBF,0x7E,0xFD,0xFB,0xF7,0x00,0x50,0x00,
+0x0D,0x07,0x01,0x02,0x01,0x0B,0x9C,0xE0,0xBD,0xEF,0x00,0x53,0x00,0x0E,0x08,0x01,0x02,0x01,0x85,0xE7,
+0xE7,0xE7,0xE7,0xA1,0x00,0x52,0x00,0x0E,0x08,0x01,0x02,0x01,0x0D,0xD7,0x5D,0x0D,0xB7,0x5E,0x00,0x5F,
+0x00,0x09,0x07,0x00,0x0B,0x00,0x01,0x00,0x66,0x00,0x0D,0x04,0x00,0x01,0x00,0xCB,0xB0,0xBB,0xBB,0xBF,
+0x00,0x67,0x00,0x0D,0x07,0x01,0x04,0x01,0x83,0x9C,0xE7,0x43,0xD1,0x00,0x65,0x00,0x0C,0x07,0x01,0x04,
+0x01,0x8B,0x80,0xF7,0x47,0x00,0x62,0x00,0x0E,0x07,0x01,0x01,0x01,0x7B,0xDE,0x17,0x39,0xCE,0x0F,0x00,
+0x63,0x00,0x0C,0x06,0x01,0x04,0x00,0x8B,0x9E,0xF7,0x47,0x00,0x61,0x00,0x0C,0x07,0x01,0x04,0x01,0x8F,
+0xA0,0xE7,0x43,0x00,0x6E,0x00,0x0C,0x07,0x01,0x04,0x01,0x0B,0x9C,0xE7,0x3B,0x00,0x6F,0x00,0x0C,0x07,
+0x01,0x04,0x01,0x8B,0x9C,0xE7,0x47,0x00,0x6C,0x00,0x0A,0x03,0x01,0x01,0x01,0x00,0x7F,0x00,0x6D,0x00,
+0x0F,0x0B,0x01,0x04,0x01,0x00,0xBB,0x9D,0xCE,0xE7,0x73,0xBB,0x00,0x68,0x00,0x0E,0x07,0x01,0x01,0x01,
+0x7B,0xDE,0x17,0x39,0xCE,0x77,0x00,0x69,0x00,0x0A,0x03,0x01,0x01,0x01,0x60,0x7F,0x00,0x77,0x00,0x0E,
+0x09,0x01,0x04,0x01,0x6C,0xD9,0x52,0xAB,0xB7,0x7F,0x00,0x76,0x00,0x0C,0x07,0x01,0x04,0x01,0x73,0xAB,
+0x5D,0xEF,0x00,0x75,0x00,0x0C,0x07,0x01,0x04,0x01,0x73,0x9C,0xE7,0x43,0x00,0x74,0x00,0x0C,0x04,0x00,
+0x02,0x00,0xBB,0x0B,0xBB,0xBC,0x00,0x73,0x00,0x0B,0x06,0x01,0x04,0x01,0x87,0x3C,0xE1,0x00,0x72,0x00,
+0x0B,0x05,0x01,0x04,0x00,0x43,0x77,0x77,0x00,0x79,0x00,0x0D,0x07,0x01,0x04,0x01,0x75,0x6B,0x5D,0xEF,
+0x77,0x00,0x78,0x00,0x0C,0x07,0x01,0x04,0x01,0x75,0x77,0xBA,0xBB,0x00,0x00,0x00,0x00,};
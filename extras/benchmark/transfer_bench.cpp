@@ -0,0 +1,342 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host benchmark and check of the asynchronous transfers through the library: displays are canvases with
+ * a chip select pin on a bus drained by PixelsHostTransfer at a simulated bus speed, so drawRasterAsync()
+ * takes the same path as on the AVR SPI interrupt. The sink writes every byte to the display whose chip
+ * select is low, and a 240x320 frame is sent strip by strip:
+ * - serial: every strip is rendered, sent and waited for
+ * - pipelined: a strip is rendered into one canvas while the other one is being sent
+ * - shared bus: two displays are drawn in turn without waiting, the chip select arbitration must keep
+ *   their pixels apart
+ * - chained: every callback starts the next strip, as an interrupt handler would
+ * - queue: the consumer finds the queue empty and a transfer is queued before the consumer releases the
+ *   head; replayed step by step, so a transfer released unsent fails in every run
+ * - stress: frames sent in 8 pixel pieces, each queued at a different point of the poll period of
+ *   the idle worker thread
+ * All the frames received must match the strips rendered, bytes must never arrive with no or two
+ * displays selected, no region may be set while the bus sends and the callbacks must come in order.
+ *
+ * Build:
+ *     g++ -O2 -I../.. -o transfer_bench transfer_bench.cpp ../../Pixels.cpp -pthread
+ *
+ * Usage:
+ *     transfer_bench [bytes per second]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pixels_Transfer.h"
+#include "Pixels_Antialiasing.h"
+#include "Pixels_Canvas.h"
+
+#define WIDTH 240
+#define HEIGHT 320
+#define STRIP 20
+#define STRIPS (HEIGHT / STRIP)
+#define PIECE 8 // pixels of a stress transfer
+#define STRESS_FRAMES 2
+
+/* a display on the host bus: selected like a driver, the queued pixels reach the canvas through the sink */
+class HostDisplay : public PixelsCanvas {
+protected:
+    PixelsHostTransfer* bus;
+
+    void beginGfxOperation() {
+        PixelsBase::beginGfxOperation();
+    }
+
+    void endGfxOperation(boolean force) {
+        PixelsBase::endGfxOperation(force);
+    }
+
+    int32_t setRegion(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+        if ( isTransferring() ) {
+            regionsWhileSending++;
+        }
+        return PixelsCanvas::setRegion(x1, y1, x2, y2);
+    }
+
+    boolean queuePixels(const uint16_t* data, uint32_t n, PixelsTransferDone done, void* context) {
+        queued++;
+        return bus->queuePixels(data, n, done, context);
+    }
+
+public:
+    regtype cs;
+    uint32_t queued;
+    uint32_t regionsWhileSending;
+
+    HostDisplay(PixelsHostTransfer* bus) : PixelsCanvas(WIDTH, HEIGHT) {
+        this->bus = bus;
+        cs = 1;
+        registerCS = &cs;
+        bitmaskCS = 1;
+        transferBusy = bus->getBusyFlag();
+        queued = regionsWhileSending = 0;
+    }
+
+    void receive(uint8_t high, uint8_t low) {
+        PixelsCanvas::deviceWriteData(high, low);
+    }
+};
+
+static HostDisplay* displays[2];
+static uint32_t strayBytes = 0;
+
+static void sink(uint8_t value, boolean command, void* context) {
+    static boolean odd = false;
+    static uint8_t high;
+
+    HostDisplay* target = NULL;
+    uint8_t selected = 0;
+    for ( uint8_t k = 0; k < 2; k++ ) {
+        if ( displays[k] != NULL && (displays[k]->cs & 1) == 0 ) {
+            target = displays[k];
+            selected++;
+        }
+    }
+    if ( selected != 1 ) {
+        strayBytes++;
+        return;
+    }
+
+    if ( odd ) {
+        target->receive(high, value);
+    } else {
+        high = value;
+    }
+    odd = !odd;
+}
+
+static uint16_t frame[WIDTH * HEIGHT];
+
+static void render(PixelsCanvas& strip, int16_t top) {
+    strip.setBackground(0, 0, 64);
+    strip.clear();
+    strip.setOriginRelative();
+    strip.enableAntialiasing(true);
+    for ( int16_t i = 0; i < 24; i++ ) {
+        strip.setColor(255 - i * 8, i * 10, 128);
+        strip.drawLine(0, i * 14 - top, WIDTH - 1, HEIGHT - 1 - i * 14 - top);
+        strip.drawCircle(WIDTH / 2, HEIGHT / 2 - top, 10 + i * 5);
+    }
+    strip.enableAntialiasing(false);
+    strip.setColor(255, 255, 0);
+    strip.fillOval(40, 200 - top, 160, 60);
+}
+
+/* callbacks record the strips in completion order */
+static volatile int16_t order[2 * STRIPS];
+static volatile int16_t completed = 0;
+
+class Strip {
+public:
+    HostDisplay* display;
+    int16_t index;
+    volatile boolean busy;
+    boolean chained;
+};
+
+static void sent(void* context) {
+    Strip* s = (Strip*)context;
+    int16_t c = completed;
+    order[c] = s->index;
+    completed = c + 1;
+    if ( s->chained && s->index + 1 < STRIPS ) {
+        // started from the callback, as the interrupt handler would
+        s->index++;
+        s->display->drawRasterAsync(0, s->index * STRIP, WIDTH, STRIP, frame + (int32_t)s->index * STRIP * WIDTH, sent, s);
+    }
+    __atomic_store_n(&s->busy, false, __ATOMIC_RELEASE);
+}
+
+static volatile uint32_t pieces = 0;
+
+static void counted(void* context) {
+    pieces = pieces + 1;
+}
+
+/* the interleaving the worker thread hits by chance, replayed step by step: the consumer finds the queue
+   empty and a transfer is queued before the consumer releases the head. The transfer must stay queued
+   and be sent whole */
+static boolean checkQueue() {
+    static const uint16_t pixels[2] = {0x1234, 0x5678};
+    PixelsTransferQueue q;
+    uint8_t value;
+    boolean command;
+    PixelsTransferDone done;
+    void* context;
+
+    boolean ok = !q.next(value, command);
+    q.enqueuePixels(pixels, 2, counted, NULL);
+    ok &= !q.complete(done, context);
+    uint8_t bytes[4];
+    uint8_t n = 0;
+    while ( n < 4 && q.next(value, command) ) {
+        bytes[n++] = value;
+    }
+    ok &= n == 4 && bytes[0] == 0x12 && bytes[1] == 0x34 && bytes[2] == 0x56 && bytes[3] == 0x78;
+    ok &= !q.next(value, command) && q.complete(done, context) && done == counted && q.isEmpty();
+    printf("%-10s a transfer queued after the consumer found the queue empty is %s\n", "queue", ok ? "kept" : "LOST");
+    return ok;
+}
+
+static void clearDisplay(HostDisplay& display) {
+    display.setBackground(0, 0, 0);
+    display.clear();
+}
+
+static boolean check(const char* name, HostDisplay& display, int16_t expected) {
+    boolean same = memcmp(display.getBuffer(), frame, sizeof(frame)) == 0;
+    boolean ordered = completed == expected;
+    for ( int16_t i = 0; i < completed && ordered; i++ ) {
+        ordered = order[i] == (expected == STRIPS ? i : i >> 1);
+    }
+    printf("%-10s frame %s, callbacks %s\n", name, same ? "matches" : "DIFFERS", ordered ? "in order" : "OUT OF ORDER");
+    return same && ordered;
+}
+
+static unsigned long run(HostDisplay& display, PixelsCanvas** canvases, boolean pipelined) {
+    static Strip strips[2];
+    clearDisplay(display);
+    completed = 0;
+
+    unsigned long start = micros();
+    for ( int16_t s = 0; s < STRIPS; s++ ) {
+        uint8_t k = pipelined ? s & 1 : 0;
+        // the canvas may still be being sent
+        while ( __atomic_load_n(&strips[k].busy, __ATOMIC_ACQUIRE) ) {
+            usleep(10);
+        }
+        render(*canvases[k], s * STRIP);
+        strips[k].index = s;
+        strips[k].busy = true;
+        strips[k].chained = false;
+        display.drawRasterAsync(0, s * STRIP, WIDTH, STRIP, (const uint16_t*)canvases[k]->getBuffer(), sent, &strips[k]);
+        if ( !pipelined ) {
+            display.waitTransfers();
+        }
+    }
+    display.waitTransfers();
+    while ( __atomic_load_n(&strips[0].busy, __ATOMIC_ACQUIRE) || __atomic_load_n(&strips[1].busy, __ATOMIC_ACQUIRE) ) {
+        usleep(10);
+    }
+    return micros() - start;
+}
+
+int main(int argc, char** argv) {
+    uint32_t speed = argc > 1 ? atol(argv[1]) : 2000000;
+
+    PixelsCanvas strip0(WIDTH, STRIP);
+    PixelsCanvas strip1(WIDTH, STRIP);
+    PixelsCanvas* canvases[2] = {&strip0, &strip1};
+    strip0.init();
+    strip1.init();
+
+    PixelsTransferQueue queue;
+    PixelsHostTransfer bus(&queue, speed, sink);
+    HostDisplay display0(&bus);
+    HostDisplay display1(&bus);
+    display0.init();
+    display1.init();
+    displays[0] = &display0;
+    displays[1] = &display1;
+    if ( !bus.start() ) {
+        fprintf(stderr, "transfer_bench: cannot start the transfer thread\n");
+        return 1;
+    }
+
+    unsigned long render0 = micros();
+    for ( int16_t s = 0; s < STRIPS; s++ ) {
+        render(strip0, s * STRIP);
+        memcpy(frame + (int32_t)s * STRIP * WIDTH, strip0.getBuffer(), sizeof(uint16_t) * STRIP * WIDTH);
+    }
+    unsigned long renderTime = micros() - render0;
+
+    boolean ok = checkQueue();
+    unsigned long serial = run(display0, canvases, false);
+    ok &= check("serial", display0, STRIPS);
+    unsigned long pipelined = run(display0, canvases, true);
+    ok &= check("pipelined", display0, STRIPS);
+
+    // two displays on the bus, each strip queued to both without waiting
+    static Strip shared[2];
+    clearDisplay(display0);
+    clearDisplay(display1);
+    completed = 0;
+    for ( int16_t s = 0; s < STRIPS; s++ ) {
+        for ( uint8_t k = 0; k < 2; k++ ) {
+            shared[k].display = displays[k];
+            shared[k].index = s;
+            shared[k].chained = false;
+            displays[k]->drawRasterAsync(0, s * STRIP, WIDTH, STRIP, frame + (int32_t)s * STRIP * WIDTH, sent, &shared[k]);
+        }
+    }
+    display0.waitTransfers();
+    display1.waitTransfers();
+    ok &= check("shared 0", display0, 2 * STRIPS);
+    ok &= check("shared 1", display1, 2 * STRIPS);
+
+    // the callbacks draw the frame; a callback run while the bus is still busy would never return
+    static Strip chain;
+    clearDisplay(display1);
+    completed = 0;
+    chain.display = &display1;
+    chain.index = 0;
+    chain.chained = true;
+    chain.busy = true;
+    display1.drawRasterAsync(0, 0, WIDTH, STRIP, frame, sent, &chain);
+    unsigned long busTime = speed > 0 ? (unsigned long)((uint64_t)WIDTH * HEIGHT * 2 * 1000000 / speed) : 0;
+    unsigned long deadline = micros() + 1000000 + 10 * busTime;
+    while ( completed < STRIPS && (long)(deadline - micros()) > 0 ) {
+        usleep(100);
+    }
+    if ( completed < STRIPS ) {
+        printf("chained    %d strips of %d sent, the callbacks stall\n", (int)completed, STRIPS);
+        fflush(stdout);
+        _exit(1);
+    }
+    display1.waitTransfers();
+    ok &= check("chained", display1, STRIPS);
+
+    uint32_t stressed = 0;
+    boolean stressFrames = true;
+    for ( uint8_t f = 0; f < STRESS_FRAMES; f++ ) {
+        clearDisplay(display0);
+        for ( int16_t y = 0; y < HEIGHT; y++ ) {
+            for ( int16_t x = 0; x < WIDTH; x += PIECE ) {
+                // queued at a pseudo random point of the poll period of the idle worker
+                display0.waitTransfers();
+                unsigned long due = micros() + (stressed * 2654435761u >> 26);
+                while ( (long)(due - micros()) > 0 ) {
+                }
+                display0.drawRasterAsync(x, y, PIECE, 1, frame + (int32_t)y * WIDTH + x, counted, NULL);
+                stressed++;
+            }
+        }
+        display0.waitTransfers();
+        bus.wait();
+        stressFrames &= memcmp(display0.getBuffer(), frame, sizeof(frame)) == 0;
+    }
+    ok &= stressFrames && pieces == stressed;
+    printf("%-10s %u pieces, %u callbacks, frames %s\n", "stress", stressed, (uint32_t)pieces, stressFrames ? "match" : "DIFFER");
+    bus.stop();
+
+    uint32_t queued = display0.queued + display1.queued;
+    uint32_t regions = display0.regionsWhileSending + display1.regionsWhileSending;
+    ok &= strayBytes == 0 && regions == 0 && queued == 5 * STRIPS + stressed;
+    printf("%u transfers queued, %u bytes with no or two displays selected, %u regions set while sending\n",
+            queued, strayBytes, regions);
+    printf("%u bytes/s: rendering %lu us, bus %lu us, serial %lu us, pipelined %lu us (%.2fx)\n",
+            speed, renderTime, busTime,
+            serial, pipelined, (double)serial / pipelined);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,555 @@
+/*
+ * Pixels. Graphics library for TFT displays.
+ *
+ * Copyright (C) 2012-2015
+ *
+ * This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License. To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+ */
+
+/*
+ * Host tool: converts PNG or PPM/PGM images to the run length encoded 'R' bitmap format
+ * drawn by PixelsBase::drawCompressedBitmap(). The format is described in Pixels.cpp.
+ *
+ * Build:
+ *     g++ -O2 -o pixels_encode pixels_encode.cpp -lz
+ *     g++ -O2 -DNO_PNG -o pixels_encode pixels_encode.cpp     (PPM/PGM input only, no zlib needed)
+ *
+ * Usage:
+ *     pixels_encode [-n name] [-g rrggbb] [-i rows] [-b] image.png|image.ppm [output]
+ *
+ *     -n name    C array name (default is derived from the file name)
+ *     -g rrggbb  background color transparent pixels are blended with (default 000000)
+ *     -i rows    store a checkpoint every given number of rows, so drawCompressedBitmapRegion()
+ *                can start decoding close to the requested part (default 0, no checkpoints)
+ *     -b         write raw bytes instead of a C array
+ *
+ * The output goes to stdout if no output file is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifndef NO_PNG
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+/* must match RLE_HASH in Pixels.cpp */
+#define RLE_HASH(c) (((c) * 3 + ((c) >> 5) * 5 + ((c) >> 11) * 7) & 0x3f)
+
+struct Image {
+    int width;
+    int height;
+    vector<uint8_t> rgba;
+};
+
+static bool fail(const char* msg, const char* arg = "") {
+    fprintf(stderr, "pixels_encode: %s%s\n", msg, arg);
+    return false;
+}
+
+static bool readFile(const char* path, vector<uint8_t>& bytes) {
+    FILE* f = fopen(path, "rb");
+    if ( f == NULL ) {
+        return fail("cannot open ", path);
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ( (n = fread(buf, 1, sizeof(buf), f)) > 0 ) {
+        bytes.insert(bytes.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+/* binary PPM (P6) or PGM (P5) with 8bit samples */
+static bool decodePnm(const vector<uint8_t>& in, Image& img) {
+    size_t pos = 2;
+    int values[3];
+    for ( int i = 0; i < 3; i++ ) {
+        while ( pos < in.size() && (isspace(in[pos]) || in[pos] == '#') ) {
+            if ( in[pos] == '#' ) {
+                while ( pos < in.size() && in[pos] != '\n' ) {
+                    pos++;
+                }
+            } else {
+                pos++;
+            }
+        }
+        values[i] = 0;
+        while ( pos < in.size() && isdigit(in[pos]) ) {
+            values[i] = values[i] * 10 + in[pos++] - '0';
+        }
+    }
+    pos++;
+
+    bool gray = in[1] == '5';
+    img.width = values[0];
+    img.height = values[1];
+    if ( values[2] != 255 || img.width <= 0 || img.height <= 0 ) {
+        return fail("only 8bit PPM/PGM images are supported");
+    }
+    size_t channels = gray ? 1 : 3;
+    if ( in.size() < pos + (size_t)img.width * img.height * channels ) {
+        return fail("truncated PPM/PGM data");
+    }
+
+    img.rgba.resize((size_t)img.width * img.height * 4);
+    for ( size_t i = 0; i < (size_t)img.width * img.height; i++ ) {
+        const uint8_t* p = &in[pos + i * channels];
+        img.rgba[i * 4 + 0] = p[0];
+        img.rgba[i * 4 + 1] = gray ? p[0] : p[1];
+        img.rgba[i * 4 + 2] = gray ? p[0] : p[2];
+        img.rgba[i * 4 + 3] = 0xff;
+    }
+    return true;
+}
+
+#ifndef NO_PNG
+static uint32_t be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+}
+
+/* non-interlaced PNG of any color type; 16bit samples are reduced to their high bytes */
+static bool decodePng(const vector<uint8_t>& in, Image& img) {
+    int depth = 0, colorType = 0;
+    vector<uint8_t> idat;
+    vector<uint8_t> palette;
+    vector<uint8_t> paletteAlpha;
+
+    size_t pos = 8;
+    while ( pos + 8 <= in.size() ) {
+        uint32_t len = be32(&in[pos]);
+        string type((const char*)&in[pos + 4], 4);
+        const uint8_t* d = &in[pos + 8];
+        if ( pos + 12 + len > in.size() ) {
+            return fail("truncated PNG chunk ", type.c_str());
+        }
+        if ( type == "IHDR" ) {
+            img.width = be32(d);
+            img.height = be32(d + 4);
+            depth = d[8];
+            colorType = d[9];
+            if ( d[12] != 0 ) {
+                return fail("interlaced PNG images are not supported");
+            }
+        } else if ( type == "PLTE" ) {
+            palette.assign(d, d + len);
+        } else if ( type == "tRNS" ) {
+            paletteAlpha.assign(d, d + len);
+        } else if ( type == "IDAT" ) {
+            idat.insert(idat.end(), d, d + len);
+        } else if ( type == "IEND" ) {
+            break;
+        }
+        pos += 12 + len;
+    }
+
+    static const int channelCounts[] = {1, 0, 3, 1, 2, 0, 4};
+    int channels = colorType <= 6 ? channelCounts[colorType] : 0;
+    if ( channels == 0 || img.width <= 0 || img.height <= 0 ) {
+        return fail("unsupported PNG color type");
+    }
+
+    size_t stride = ((size_t)img.width * channels * depth + 7) / 8;
+    size_t bpp = (channels * depth + 7) / 8;
+    vector<uint8_t> raw((stride + 1) * img.height);
+    uLongf rawLength = raw.size();
+    if ( uncompress(&raw[0], &rawLength, &idat[0], idat.size()) != Z_OK || rawLength != raw.size() ) {
+        return fail("corrupted PNG image data");
+    }
+
+    img.rgba.resize((size_t)img.width * img.height * 4);
+    vector<uint8_t> prev(stride, 0);
+    for ( int y = 0; y < img.height; y++ ) {
+        uint8_t filter = raw[y * (stride + 1)];
+        uint8_t* row = &raw[y * (stride + 1) + 1];
+        for ( size_t i = 0; i < stride; i++ ) {
+            int a = i >= bpp ? row[i - bpp] : 0;
+            int b = prev[i];
+            int c = i >= bpp ? prev[i - bpp] : 0;
+            switch ( filter ) {
+            case 1: row[i] += a; break;
+            case 2: row[i] += b; break;
+            case 3: row[i] += (a + b) / 2; break;
+            case 4: row[i] += paeth(a, b, c); break;
+            }
+        }
+        prev.assign(row, row + stride);
+
+        for ( int x = 0; x < img.width; x++ ) {
+            uint8_t s[4];
+            for ( int ch = 0; ch < channels; ch++ ) {
+                if ( depth < 8 ) {
+                    size_t bit = (size_t)x * depth;
+                    int v = (row[bit / 8] >> (8 - depth - bit % 8)) & ((1 << depth) - 1);
+                    s[ch] = colorType == 3 ? v : v * 255 / ((1 << depth) - 1);
+                } else {
+                    s[ch] = row[((size_t)x * channels + ch) * (depth / 8)];
+                }
+            }
+            uint8_t* o = &img.rgba[((size_t)y * img.width + x) * 4];
+            switch ( colorType ) {
+            case 0:
+                o[0] = o[1] = o[2] = s[0];
+                o[3] = 0xff;
+                break;
+            case 2:
+                o[0] = s[0];
+                o[1] = s[1];
+                o[2] = s[2];
+                o[3] = 0xff;
+                break;
+            case 3:
+                if ( (size_t)s[0] * 3 + 2 >= palette.size() ) {
+                    return fail("PNG palette index out of range");
+                }
+                o[0] = palette[s[0] * 3];
+                o[1] = palette[s[0] * 3 + 1];
+                o[2] = palette[s[0] * 3 + 2];
+                o[3] = s[0] < paletteAlpha.size() ? paletteAlpha[s[0]] : 0xff;
+                break;
+            case 4:
+                o[0] = o[1] = o[2] = s[0];
+                o[3] = s[1];
+                break;
+            case 6:
+                o[0] = s[0];
+                o[1] = s[1];
+                o[2] = s[2];
+                o[3] = s[3];
+                break;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+static bool decodeImage(const char* path, Image& img) {
+    vector<uint8_t> in;
+    if ( !readFile(path, in) ) {
+        return false;
+    }
+    if ( in.size() > 2 && in[0] == 'P' && (in[1] == '5' || in[1] == '6') ) {
+        return decodePnm(in, img);
+    }
+    if ( in.size() > 8 && memcmp(&in[0], "\x89PNG\r\n\x1a\n", 8) == 0 ) {
+#ifndef NO_PNG
+        return decodePng(in, img);
+#else
+        return fail("built without PNG support: ", path);
+#endif
+    }
+    return fail("unknown image format: ", path);
+}
+
+/* converts to 565 the way RGB::convertTo565() does, blending translucent pixels with the background */
+static vector<uint16_t> toPixels(const Image& img, uint32_t background) {
+    vector<uint16_t> pixels((size_t)img.width * img.height);
+    for ( size_t i = 0; i < pixels.size(); i++ ) {
+        const uint8_t* p = &img.rgba[i * 4];
+        int c[3];
+        for ( int ch = 0; ch < 3; ch++ ) {
+            int bg = (background >> (16 - ch * 8)) & 0xff;
+            c[ch] = (p[ch] * p[3] + bg * (255 - p[3])) / 255;
+        }
+        pixels[i] = ((c[0] / 8) << 11) | ((c[1] / 4) << 5) | (c[2] / 8);
+    }
+    return pixels;
+}
+
+/* 10rrggbb opcode for the color change, or -1 if a channel changes by more than -2..1 */
+static int diffOp(uint16_t from, uint16_t to) {
+    int dr = ((to >> 11) - (from >> 11) + 2) & 0x1f;
+    int dg = (((to >> 5) & 0x3f) - ((from >> 5) & 0x3f) + 2) & 0x3f;
+    int db = ((to & 0x1f) - (from & 0x1f) + 2) & 0x1f;
+    if ( dr > 3 || dg > 3 || db > 3 ) {
+        return -1;
+    }
+    return 0x80 | (dr << 4) | (dg << 2) | db;
+}
+
+/* 110ggggg rrrrbbbb opcode pair for the color change, or -1 if the change does not fit */
+static int lumaOp(uint16_t from, uint16_t to) {
+    int dg = ((((to >> 5) & 0x3f) - ((from >> 5) & 0x3f) + 32) & 0x3f) - 32;
+    if ( dg < -16 || dg > 15 ) {
+        return -1;
+    }
+    int h = dg >> 1;
+    int dr = ((((to >> 11) - (from >> 11) - h) + 16) & 0x1f) - 16;
+    int db = ((((to & 0x1f) - (from & 0x1f) - h) + 16) & 0x1f) - 16;
+    if ( dr < -8 || dr > 7 || db < -8 || db > 7 ) {
+        return -1;
+    }
+    return ((0xc0 | (dg + 16)) << 8) | ((dr + 8) << 4) | (db + 8);
+}
+
+static void put24(vector<uint8_t>& data, size_t value) {
+    data.push_back(value >> 16);
+    data.push_back(value >> 8);
+    data.push_back(value);
+}
+
+/* checkpoint rows reset the encoder state, no opcode reaches across them */
+static vector<uint8_t> encode(const vector<uint16_t>& pixels, int width, int height, int interval) {
+    vector<uint8_t> out;
+    vector<size_t> checkpoints;
+    uint16_t table[64];
+    uint16_t color = 0;
+    long literalOp = -1; // position of the last literal opcode if it can take more pixels
+    size_t segmentStart = 0;
+    size_t segmentEnd = 0;
+
+    for ( size_t i = 0; i < pixels.size(); ) {
+        if ( i == segmentEnd ) {
+            if ( i > 0 ) {
+                checkpoints.push_back(out.size());
+            }
+            memset(table, 0, sizeof(table));
+            color = 0;
+            literalOp = -1;
+            segmentStart = i;
+            segmentEnd = interval > 0 ? min(pixels.size(), i + (size_t)interval * width) : pixels.size();
+        }
+        uint16_t c = pixels[i];
+
+        size_t run = 0;
+        while ( i + run < segmentEnd && pixels[i + run] == color && run < 64 ) {
+            run++;
+        }
+        size_t up = 0;
+        while ( i >= segmentStart + width && i + up < segmentEnd && pixels[i + up] == pixels[i + up - width] && up < 16 ) {
+            up++;
+        }
+
+        if ( up > 1 && up > run ) {
+            out.push_back(0xf0 | (up - 1));
+            color = pixels[i + up - 1];
+            i += up;
+            literalOp = -1;
+            continue;
+        }
+        if ( run > 0 ) {
+            out.push_back(run - 1);
+            i += run;
+            literalOp = -1;
+            continue;
+        }
+
+        int diff = diffOp(color, c);
+        int luma = lumaOp(color, c);
+        if ( table[RLE_HASH(c)] == c ) {
+            out.push_back(0x40 | RLE_HASH(c));
+            literalOp = -1;
+        } else if ( diff >= 0 ) {
+            out.push_back(diff);
+            literalOp = -1;
+        } else if ( luma >= 0 ) {
+            out.push_back(luma >> 8);
+            out.push_back(luma & 0xff);
+            literalOp = -1;
+        } else {
+            if ( literalOp >= 0 && (out[literalOp] & 0x0f) < 0x0f ) {
+                out[literalOp]++;
+            } else {
+                literalOp = out.size();
+                out.push_back(0xe0);
+            }
+            out.push_back(c >> 8);
+            out.push_back(c & 0xff);
+        }
+        table[RLE_HASH(c)] = c;
+        color = c;
+        i++;
+    }
+
+    vector<uint8_t> data;
+    data.push_back('R');
+    put24(data, out.size());
+    data.push_back(width >> 8);
+    data.push_back(width);
+    data.push_back(height >> 8);
+    data.push_back(height);
+    data.push_back(interval >> 8);
+    data.push_back(interval);
+    for ( size_t i = 0; i < checkpoints.size(); i++ ) {
+        put24(data, checkpoints[i]);
+    }
+    data.insert(data.end(), out.begin(), out.end());
+    return data;
+}
+
+/* reference decoder, mirrors PixelsBase::drawRunLengthBitmap() */
+static vector<uint16_t> decode(const vector<uint8_t>& data) {
+    size_t length = ((size_t)data[1] << 16) | (data[2] << 8) | data[3];
+    size_t width = (data[4] << 8) | data[5];
+    size_t height = (data[6] << 8) | data[7];
+    size_t interval = (data[8] << 8) | data[9];
+    size_t start = 10 + (interval > 0 ? (height - 1) / interval * 3 : 0);
+    vector<uint16_t> pixels;
+    uint16_t table[64] = {0};
+    uint16_t color = 0;
+    size_t segmentStart = 0;
+
+    for ( size_t p = start; p < start + length && pixels.size() < width * height; ) {
+        uint8_t op = data[p++];
+        int n = 1;
+        if ( op < 0x40 ) {
+            n = op + 1;
+        } else if ( op < 0x80 ) {
+            color = table[op & 0x3f];
+        } else if ( op < 0xc0 ) {
+            uint16_t r = ((color >> 11) + ((op >> 4) & 3) - 2) & 0x1f;
+            uint16_t g = ((color >> 5) + ((op >> 2) & 3) - 2) & 0x3f;
+            uint16_t b = (color + (op & 3) - 2) & 0x1f;
+            color = (r << 11) | (g << 5) | b;
+            table[RLE_HASH(color)] = color;
+        } else if ( op < 0xe0 ) {
+            uint8_t rb = data[p++];
+            int dg = (op & 0x1f) - 16;
+            int h = dg >> 1;
+            uint16_t r = ((color >> 11) + h + (rb >> 4) - 8) & 0x1f;
+            uint16_t g = ((color >> 5) + dg) & 0x3f;
+            uint16_t b = (color + h + (rb & 0x0f) - 8) & 0x1f;
+            color = (r << 11) | (g << 5) | b;
+            table[RLE_HASH(color)] = color;
+        } else {
+            n = (op & 0x0f) + 1;
+        }
+        for ( ; n > 0; n-- ) {
+            if ( op >= 0xf0 ) {
+                color = pixels.size() >= segmentStart + width ? pixels[pixels.size() - width] : 0;
+            } else if ( op >= 0xe0 ) {
+                color = (data[p] << 8) | data[p + 1];
+                p += 2;
+                table[RLE_HASH(color)] = color;
+            }
+            pixels.push_back(color);
+            if ( interval > 0 && pixels.size() % (interval * width) == 0 ) {
+                memset(table, 0, sizeof(table));
+                color = 0;
+                segmentStart = pixels.size();
+                break;
+            }
+        }
+    }
+    pixels.resize(width * height);
+    return pixels;
+}
+
+static string arrayName(const char* path) {
+    string name = path;
+    size_t slash = name.find_last_of("/\\");
+    if ( slash != string::npos ) {
+        name = name.substr(slash + 1);
+    }
+    for ( size_t i = 0; i < name.size(); i++ ) {
+        if ( !isalnum(name[i]) ) {
+            name[i] = '_';
+        }
+    }
+    if ( name.empty() || isdigit(name[0]) ) {
+        name = "img_" + name;
+    }
+    return name;
+}
+
+int main(int argc, char** argv) {
+    const char* input = NULL;
+    const char* output = NULL;
+    string name;
+    uint32_t background = 0;
+    bool binary = false;
+    int interval = 0;
+
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strcmp(argv[i], "-n") == 0 && i + 1 < argc ) {
+            name = argv[++i];
+        } else if ( strcmp(argv[i], "-g") == 0 && i + 1 < argc ) {
+            background = strtoul(argv[++i], NULL, 16);
+        } else if ( strcmp(argv[i], "-i") == 0 && i + 1 < argc ) {
+            interval = atoi(argv[++i]);
+        } else if ( strcmp(argv[i], "-b") == 0 ) {
+            binary = true;
+        } else if ( input == NULL ) {
+            input = argv[i];
+        } else {
+            output = argv[i];
+        }
+    }
+    if ( input == NULL ) {
+        fprintf(stderr, "usage: pixels_encode [-n name] [-g rrggbb] [-i rows] [-b] image.png|image.ppm [output]\n");
+        return 2;
+    }
+
+    Image img;
+    if ( !decodeImage(input, img) ) {
+        return 1;
+    }
+    if ( img.width > 0x7fff || img.height > 0x7fff ) {
+        fail("image is too large");
+        return 1;
+    }
+    if ( interval < 0 || interval > 0x7fff ) {
+        fail("invalid checkpoint interval");
+        return 1;
+    }
+
+    vector<uint16_t> pixels = toPixels(img, background);
+    vector<uint8_t> data = encode(pixels, img.width, img.height, interval);
+    if ( data.size() > 0xffffff || decode(data) != pixels ) {
+        fail("encoding failed for ", input);
+        return 1;
+    }
+
+    FILE* out = output == NULL ? stdout : fopen(output, binary ? "wb" : "w");
+    if ( out == NULL ) {
+        fail("cannot write ", output);
+        return 1;
+    }
+
+    if ( binary ) {
+        fwrite(&data[0], 1, data.size(), out);
+    } else {
+        if ( name.empty() ) {
+            name = arrayName(input);
+        }
+        fprintf(out, "\tprog_uchar %s[%u] PROGMEM = { //:Wiring\n\t", name.c_str(), (unsigned)data.size());
+        for ( size_t i = 0; i < data.size(); i++ ) {
+            fprintf(out, "0x%02X,", data[i]);
+            if ( i % 20 == 19 && i + 1 < data.size() ) {
+                fprintf(out, "\n\t");
+            }
+        }
+        fprintf(out, "};\n\t/*\n\tarray size:   %u\n\timage size:   %dx%d\n\tusage:\n\t\tpxs.drawCompressedBitmap(x, y, %s);\n",
+                (unsigned)data.size(), img.width, img.height, name.c_str());
+        if ( interval > 0 ) {
+            fprintf(out, "\t\tpxs.drawCompressedBitmapRegion(x, y, %s, sx, sy, width, height);\n", name.c_str());
+        }
+        fprintf(out, "\t*/\n");
+    }
+
+    if ( out != stdout ) {
+        fclose(out);
+    }
+
+    fprintf(stderr, "%s: %dx%d, %u bytes (%u bytes raw 565)\n", input, img.width, img.height,
+            (unsigned)data.size(), (unsigned)pixels.size() * 2);
+    return 0;
+}